@@ -6,7 +6,7 @@
 */
 
 #include "listeneradapter_p.h"
-#include <QDebug>
+#include "polkitqt1-agent-debug_p.h"
 #define POLKIT_AGENT_I_KNOW_API_IS_SUBJECT_TO_CHANGE 1
 #include <polkitagent/polkitagent.h>
 
@@ -59,6 +59,19 @@ Listener* ListenerAdapter::findListener(PolkitAgentListener *listener)
     return nullptr;
 }
 
+PolkitQt1::Identity::List uniqueIdentities(GList *identities)
+{
+    // Polkit enumerates identities without regard for their hash value, potentially leading to duplicated entries.
+    // Unique the identities on our end.
+    // https://github.com/polkit-org/polkit/issues/542
+    QHash<guint, PolkitQt1::Identity> unique;
+    for (GList *entry = g_list_first(identities); entry != nullptr; entry = g_list_next(entry)) {
+        auto identity = static_cast<PolkitIdentity *>(entry->data);
+        unique.insert(polkit_identity_hash(identity), PolkitQt1::Identity(identity));
+    }
+    return unique.values();
+}
+
 void ListenerAdapter::polkit_qt_listener_initiate_authentication(PolkitAgentListener  *listener,
         const gchar          *action_id,
         const gchar          *message,
@@ -69,27 +82,18 @@ void ListenerAdapter::polkit_qt_listener_initiate_authentication(PolkitAgentList
         GCancellable         *cancellable,
         GSimpleAsyncResult *result)
 {
-    qDebug() << "polkit_qt_listener_initiate_authentication callback for " << listener;
+    qCDebug(POLKITQT1_AGENT, "initiate authentication listener=%p action=%s", static_cast<void *>(listener), action_id);
 
     PolkitQt1::Details dets(details);
 
     Listener *list = findListener(listener);
 
-    // Polkit enumerates identities without regard for their hash value, potentially leading to duplicated entries.
-    // Unique the identities on our end.
-    // https://github.com/polkit-org/polkit/issues/542
-    QHash<guint, PolkitQt1::Identity> uniqueIdentities;
-    for (GList *entry = g_list_first(identities); entry != nullptr; entry = g_list_next(entry)) {
-        auto identity = static_cast<PolkitIdentity *>(entry->data);
-        uniqueIdentities.insert(polkit_identity_hash(identity), PolkitQt1::Identity(identity));
-    }
-
     list->initiateAuthentication(QString::fromUtf8(action_id),
                                  QString::fromUtf8(message),
                                  QString::fromUtf8(icon_name),
                                  dets,
                                  QString::fromUtf8(cookie),
-                                 uniqueIdentities.values(),
+                                 uniqueIdentities(identities),
                                  new AsyncResult(result));
 }
 
@@ -97,7 +101,7 @@ gboolean ListenerAdapter::polkit_qt_listener_initiate_authentication_finish(Polk
         GAsyncResult         *res,
         GError              **error)
 {
-    qDebug() << "polkit_qt_listener_initiate_authentication_finish callback for " << listener;
+    qCDebug(POLKITQT1_AGENT, "initiate authentication finish listener=%p", static_cast<void *>(listener));
 
     GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT(res);
     if (g_simple_async_result_propagate_error(simple, error)) {
@@ -108,7 +112,7 @@ gboolean ListenerAdapter::polkit_qt_listener_initiate_authentication_finish(Polk
 
 void ListenerAdapter::cancelled_cb(PolkitAgentListener *listener)
 {
-    qDebug() << "cancelled_cb for " << listener;
+    qCDebug(POLKITQT1_AGENT, "authentication cancelled listener=%p", static_cast<void *>(listener));
 
     Listener *list = findListener(listener);
 
@@ -117,14 +121,14 @@ void ListenerAdapter::cancelled_cb(PolkitAgentListener *listener)
 
 void ListenerAdapter::addListener(Listener *listener)
 {
-    qDebug() << "Adding new listener " << listener << "for " << listener->listener();
+    qCDebug(POLKITQT1_AGENT) << "Adding new listener" << listener << "for" << listener->listener();
 
     m_listeners.append(listener);
 }
 
 void ListenerAdapter::removeListener(Listener *listener)
 {
-    qDebug() << "Removing listener " << listener;
+    qCDebug(POLKITQT1_AGENT) << "Removing listener" << listener;
 
     // should be safe as we don't have more than one same listener registered in one time
     m_listeners.removeOne(listener);
@@ -30,6 +30,13 @@ namespace Agent
 
 class AsyncResult;
 class Listener;
+
+/**
+ * \internal
+ * Converts the identities polkit offers for authentication, dropping duplicates.
+ */
+PolkitQt1::Identity::List uniqueIdentities(GList *identities);
+
 class ListenerAdapter : public QObject
 {
     Q_OBJECT
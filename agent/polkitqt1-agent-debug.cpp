@@ -0,0 +1,11 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-agent-debug_p.h"
+
+// Only warnings are shown by default, enable the rest with QT_LOGGING_RULES
+Q_LOGGING_CATEGORY(POLKITQT1_AGENT, "polkit-qt-1.agent", QtWarningMsg)
+Q_LOGGING_CATEGORY(POLKITQT1_AGENT_SESSION, "polkit-qt-1.agent.session", QtWarningMsg)
@@ -7,8 +7,7 @@
 
 #include "polkitqt1-agent-listener.h"
 
-#include <QDebug>
-
+#include "polkitqt1-agent-debug_p.h"
 #include "polkitqtlistener_p.h"
 
 #include "polkitqt1-authority.h"
@@ -36,7 +35,7 @@ Listener::Listener(QObject *parent)
 {
     d->listener = polkit_qt_listener_new();
 
-    qDebug() << "New PolkitAgentListener " << d->listener;
+    qCDebug(POLKITQT1_AGENT) << "New PolkitAgentListener" << d->listener;
 
     ListenerAdapter::instance()->addListener(this);
 }
@@ -53,7 +52,7 @@ Listener::Listener(PolkitAgentListener *listener, QObject *parent)
 
 Listener::~Listener()
 {
-    qDebug("Destroying listener");
+    qCDebug(POLKITQT1_AGENT, "Destroying listener");
 
     ListenerAdapter::instance()->removeListener(this);
 #ifndef POLKIT_QT_1_COMPATIBILITY_MODE
@@ -84,13 +83,13 @@ bool Listener::registerListener(const PolkitQt1::Subject &subject, const QString
                                             &error);
 
     if (error != nullptr) {
-        qWarning() << QString("Cannot register authentication agent: %1").arg(error->message);
+        qCWarning(POLKITQT1_AGENT) << "Cannot register authentication agent:" << error->message;
         g_error_free(error);
         return false;
     }
 #ifndef POLKIT_QT_1_COMPATIBILITY_MODE
     if (d->registeredHandle == nullptr) {
-        qWarning() << QString("Cannot register authentication agent!");
+        qCWarning(POLKITQT1_AGENT, "Cannot register authentication agent!");
         return false;
     }
     return true;
@@ -7,9 +7,11 @@
 
 #include "polkitqt1-agent-session.h"
 
-#include <QDebug>
+#include <QElapsedTimer>
 
+#include "polkitqt1-agent-debug_p.h"
 #include "polkitqt1-identity.h"
+#include "polkitqt1-tracer.h"
 
 #define POLKIT_AGENT_I_KNOW_API_IS_SUBJECT_TO_CHANGE 1
 #include <polkitagent/polkitagent.h>
@@ -19,7 +21,7 @@ using namespace PolkitQt1::Agent;
 class Session::Private
 {
 public:
-    Private() {}
+    Private() : traceId(0) {}
     ~Private();
 
     static void completed(PolkitAgentSession *s, gboolean gained_authorization, gpointer user_data);
@@ -29,6 +31,10 @@ public:
 
     AsyncResult *result;
     PolkitAgentSession *polkitAgentSession;
+    // Only started while debug output is enabled
+    QElapsedTimer initiated;
+    // Span from initiate() until completed
+    quint64 traceId;
 };
 
 Session::Private::~Private()
@@ -72,6 +78,11 @@ Session::~Session()
 
 void Session::initiate()
 {
+    if (POLKITQT1_AGENT_SESSION().isDebugEnabled()) {
+        d->initiated.start();
+    }
+    qCDebug(POLKITQT1_AGENT_SESSION, "session initiate session=%p", static_cast<void *>(this));
+    d->traceId = Tracer::beginAsyncEvent("agent.session", "session");
     polkit_agent_session_initiate(d->polkitAgentSession);
 }
 
@@ -92,8 +103,12 @@ AsyncResult *Session::result()
 
 void Session::Private::completed(PolkitAgentSession *s, gboolean gained_authorization, gpointer user_data)
 {
-    qDebug() << "COMPLETED";
     Session *session = (Session *)user_data;
+    qCDebug(POLKITQT1_AGENT_SESSION, "session completed session=%p gained=%d elapsed_us=%lld",
+            static_cast<void *>(session), int(gained_authorization),
+            session->d->initiated.isValid() ? session->d->initiated.nsecsElapsed() / 1000 : qint64(-1));
+    Tracer::endAsyncEvent("agent.session", "session", session->d->traceId);
+    session->d->traceId = 0;
     Q_EMIT(session)->completed(gained_authorization);
 
     //free session here as polkit documentation asks
@@ -103,19 +118,19 @@ void Session::Private::completed(PolkitAgentSession *s, gboolean gained_authoriz
 
 void Session::Private::request(PolkitAgentSession *s, gchar *request, gboolean echo_on, gpointer user_data)
 {
-    qDebug() << "REQUEST";
+    qCDebug(POLKITQT1_AGENT_SESSION, "session request echo=%d", int(echo_on));
     Q_EMIT((Session *)user_data)->request(QString::fromUtf8(request), echo_on);
 }
 
 void Session::Private::showError(PolkitAgentSession *s, gchar *text, gpointer user_data)
 {
-    qDebug() << "showError";
+    qCDebug(POLKITQT1_AGENT_SESSION, "session showError");
     Q_EMIT((Session *)user_data)->showError(QString::fromUtf8(text));
 }
 
 void Session::Private::showInfo(PolkitAgentSession *s, gchar *text, gpointer user_data)
 {
-    qDebug() << "showInfo";
+    qCDebug(POLKITQT1_AGENT_SESSION, "session showInfo");
     Q_EMIT((Session *)user_data)->showInfo(QString::fromUtf8(text));
 }
 
@@ -124,14 +139,23 @@ void Session::Private::showInfo(PolkitAgentSession *s, gchar *text, gpointer use
 class AsyncResult::Private
 {
 public:
-    Private(GSimpleAsyncResult *r) : result(r) {};
+    Private(GSimpleAsyncResult *r) : result(r), traceId(0) {};
 
     GSimpleAsyncResult *result;
+    // From initiateAuthentication() until the result is reported, only
+    // started while debug output is enabled
+    QElapsedTimer started;
+    // Span from initiateAuthentication() until the result is reported
+    quint64 traceId;
 };
 
 AsyncResult::AsyncResult(GSimpleAsyncResult *result)
         : d(new Private(result))
 {
+    if (POLKITQT1_AGENT().isDebugEnabled()) {
+        d->started.start();
+    }
+    d->traceId = Tracer::beginAsyncEvent("agent", "initiateAuthentication");
 }
 
 AsyncResult::~AsyncResult()
@@ -144,6 +168,10 @@ void AsyncResult::setCompleted()
 {
     if (d->result == nullptr)
         return;
+    qCDebug(POLKITQT1_AGENT, "authentication completed elapsed_us=%lld",
+            d->started.isValid() ? d->started.nsecsElapsed() / 1000 : qint64(-1));
+    Tracer::endAsyncEvent("agent", "initiateAuthentication", d->traceId);
+    d->traceId = 0;
     g_simple_async_result_complete(d->result);
     // Assure that completed won't be called twice
     g_object_unref(d->result);
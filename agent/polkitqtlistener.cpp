@@ -8,10 +8,9 @@
 
 
 #include "polkitqtlistener_p.h"
+#include "polkitqt1-agent-debug_p.h"
 #include <stdio.h>
 
-#include <QDebug>
-
 #define POLKIT_AGENT_I_KNOW_API_IS_SUBJECT_TO_CHANGE 1
 
 using namespace PolkitQt1::Agent;
@@ -97,7 +96,7 @@ static void polkit_qt_listener_initiate_authentication(PolkitAgentListener  *age
         GAsyncReadyCallback   callback,
         gpointer              user_data)
 {
-    qDebug() << "Listener adapter polkit_qt_listener_initiate_authentication";
+    qCDebug(POLKITQT1_AGENT) << "Listener adapter polkit_qt_listener_initiate_authentication";
     PolkitQtListener *listener = POLKIT_QT_LISTENER(agent_listener);
 
     if (cancellable != nullptr) {
@@ -109,7 +108,7 @@ static void polkit_qt_listener_initiate_authentication(PolkitAgentListener  *age
 
     // The result of asynchronous method will be created here and it will be pushed to the listener.
     GSimpleAsyncResult *result = g_simple_async_result_new((GObject *) listener, callback, user_data, agent_listener);
-    qDebug() << "GSimpleAsyncResult:" << result;
+    qCDebug(POLKITQT1_AGENT) << "GSimpleAsyncResult:" << result;
 
     ListenerAdapter::instance()->polkit_qt_listener_initiate_authentication(agent_listener,
             action_id,
@@ -127,7 +126,7 @@ static gboolean polkit_qt_listener_initiate_authentication_finish(PolkitAgentLis
         GAsyncResult         *res,
         GError              **error)
 {
-    qDebug() << "Listener adapter polkit_qt_listener_initiate_authentication_finish";
+    qCDebug(POLKITQT1_AGENT) << "Listener adapter polkit_qt_listener_initiate_authentication_finish";
     return ListenerAdapter::instance()->polkit_qt_listener_initiate_authentication_finish(listener,
             res,
             error);
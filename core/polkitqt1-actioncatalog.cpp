@@ -0,0 +1,265 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-actioncatalog.h"
+#include "polkitqt1-actionsnapshot_p.h"
+#include "polkitqt1-authority.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace PolkitQt1
+{
+
+class Q_DECL_HIDDEN ActionCatalog::Private
+{
+public:
+    explicit Private(ActionCatalog *parent)
+        : q(parent)
+        , loaded(false)
+        , refreshPending(false)
+        , snapshotCurrent(false)
+    {
+    }
+
+    bool apply(const ActionDescription::List &actions);
+    void refreshed(bool changed);
+    void refreshFinished();
+
+    ActionCatalog *q;
+    QHash<QString, ActionDescription> actions;
+    // Keys of actions, sorted for actions() and the prefix queries
+    QStringList ids;
+    QFutureWatcher<Authority::ActionsResult> watcher;
+    QMetaObject::Connection configChanged;
+    bool loaded;
+    // refresh() was called while the watcher was busy
+    bool refreshPending;
+    QString snapshotFile;
+    // The snapshot file holds what the catalog holds
+    bool snapshotCurrent;
+};
+
+bool ActionCatalog::Private::apply(const ActionDescription::List &list)
+{
+    QHash<QString, ActionDescription> next;
+    next.reserve(list.size());
+    ActionDescription::List added;
+    ActionDescription::List changed;
+    for (const ActionDescription &action : list) {
+        const QString actionId = action.actionId();
+        next.insert(actionId, action);
+
+        const auto it = actions.constFind(actionId);
+        if (it == actions.constEnd()) {
+            added.append(action);
+        } else if (it.value() != action) {
+            changed.append(action);
+        }
+    }
+
+    QStringList removed;
+    if (actions.size() != next.size() - added.size()) {
+        for (auto it = actions.constBegin(); it != actions.constEnd(); ++it) {
+            if (!next.contains(it.key())) {
+                removed.append(it.key());
+            }
+        }
+        std::sort(removed.begin(), removed.end());
+    }
+
+    actions.swap(next);
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        ids = actions.keys();
+        std::sort(ids.begin(), ids.end());
+    }
+    loaded = true;
+
+    if (!removed.isEmpty()) {
+        Q_EMIT q->actionsRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        Q_EMIT q->actionsAdded(added);
+    }
+    if (!changed.isEmpty()) {
+        Q_EMIT q->actionsChanged(changed);
+    }
+    return !added.isEmpty() || !removed.isEmpty() || !changed.isEmpty();
+}
+
+void ActionCatalog::Private::refreshed(bool changed)
+{
+    if (changed) {
+        snapshotCurrent = false;
+    }
+    if (!snapshotCurrent && !snapshotFile.isEmpty()) {
+        snapshotCurrent = ActionSnapshot::write(snapshotFile, q->actions());
+    }
+
+    Q_EMIT q->refreshed();
+}
+
+void ActionCatalog::Private::refreshFinished()
+{
+    // A cancelled future has no result
+    const QFuture<Authority::ActionsResult> future = watcher.future();
+    if (!future.isCanceled()) {
+        const Authority::ActionsResult result = future.result();
+        if (!result.isError()) {
+            refreshed(apply(result.actions));
+        }
+    }
+
+    if (refreshPending) {
+        refreshPending = false;
+        q->refresh();
+    }
+}
+
+ActionCatalog::ActionCatalog(QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    connect(&d->watcher, &QFutureWatcherBase::finished, this, [this]() {
+        d->refreshFinished();
+    });
+    setAutoRefresh(true);
+}
+
+ActionCatalog::~ActionCatalog()
+{
+    delete d;
+}
+
+void ActionCatalog::refresh()
+{
+    if (isRefreshing()) {
+        d->refreshPending = true;
+        return;
+    }
+
+    d->watcher.setFuture(Authority::instance()->enumerateActionsResultAsync());
+}
+
+bool ActionCatalog::refreshSync()
+{
+    const Authority::ActionsResult result = Authority::instance()->enumerateActionsResultSync();
+    if (result.isError()) {
+        return false;
+    }
+
+    d->refreshed(d->apply(result.actions));
+    return true;
+}
+
+bool ActionCatalog::isRefreshing() const
+{
+    return d->watcher.isRunning();
+}
+
+bool ActionCatalog::isLoaded() const
+{
+    return d->loaded;
+}
+
+void ActionCatalog::setAutoRefresh(bool enabled)
+{
+    if (enabled == autoRefresh()) {
+        return;
+    }
+
+    if (enabled) {
+        d->configChanged = connect(Authority::instance(), &Authority::configChanged, this, &ActionCatalog::refresh);
+    } else {
+        disconnect(d->configChanged);
+        d->configChanged = QMetaObject::Connection();
+    }
+}
+
+bool ActionCatalog::autoRefresh() const
+{
+    return d->configChanged;
+}
+
+void ActionCatalog::setSnapshotFile(const QString &fileName)
+{
+    if (fileName != d->snapshotFile) {
+        d->snapshotFile = fileName;
+        d->snapshotCurrent = false;
+    }
+}
+
+QString ActionCatalog::snapshotFile() const
+{
+    return d->snapshotFile;
+}
+
+QString ActionCatalog::defaultSnapshotFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + QLatin1String("/polkit-qt-1/actions.snapshot");
+}
+
+bool ActionCatalog::loadSnapshot()
+{
+    ActionDescription::List actions;
+    if (d->snapshotFile.isEmpty() || !ActionSnapshot::read(d->snapshotFile, &actions)) {
+        return false;
+    }
+
+    d->apply(actions);
+    d->snapshotCurrent = true;
+    return true;
+}
+
+int ActionCatalog::count() const
+{
+    return d->actions.size();
+}
+
+bool ActionCatalog::contains(const QString &actionId) const
+{
+    return d->actions.contains(actionId);
+}
+
+ActionDescription ActionCatalog::lookup(const QString &actionId) const
+{
+    return d->actions.value(actionId);
+}
+
+ActionDescription::List ActionCatalog::actions() const
+{
+    const QStringList &ids = d->ids;
+    ActionDescription::List result;
+    result.reserve(ids.size());
+    for (const QString &actionId : ids) {
+        result.append(d->actions.value(actionId));
+    }
+    return result;
+}
+
+QStringList ActionCatalog::actionIds() const
+{
+    return d->ids;
+}
+
+ActionDescription::List ActionCatalog::actionsWithPrefix(const QString &prefix) const
+{
+    ActionDescription::List result;
+    // All ids starting with prefix follow each other, beginning at the first one not less than it
+    for (auto it = std::lower_bound(d->ids.constBegin(), d->ids.constEnd(), prefix);
+         it != d->ids.constEnd() && it->startsWith(prefix); ++it) {
+        result.append(d->actions.value(*it));
+    }
+    return result;
+}
+
+}
+
+#include "moc_polkitqt1-actioncatalog.cpp"
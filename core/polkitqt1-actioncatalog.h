@@ -0,0 +1,194 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_ACTIONCATALOG_H
+#define POLKITQT1_ACTIONCATALOG_H
+
+#include "polkitqt1-core-export.h"
+#include "polkitqt1-actiondescription.h"
+
+#include <QObject>
+#include <QStringList>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class ActionCatalog polkitqt1-actioncatalog.h ActionCatalog
+ *
+ * \brief Keeps the actions registered with polkitd, indexed by action id
+ *
+ * Authority::enumerateActionsSync() returns thousands of actions on a full
+ * desktop as a plain list. ActionCatalog keeps them indexed instead: lookup()
+ * finds an action by its id in constant time, actionsWithPrefix() returns all
+ * actions of a namespace like \c org.freedesktop.udisks2 without scanning the
+ * others.
+ *
+ * Whenever Authority::configChanged() is emitted the catalog enumerates the
+ * actions again in the background and reports the difference to what it held
+ * before through actionsAdded(), actionsRemoved() and actionsChanged(), so
+ * receivers only have to update what actually changed.
+ *
+ * The catalog is empty until the first refresh finished. A program that shows
+ * the actions right when it starts can keep a snapshot of the catalog on disk
+ * and fill the catalog from it before refreshing it in the background:
+ *
+ * \code
+ * catalog->setSnapshotFile(ActionCatalog::defaultSnapshotFile());
+ * catalog->loadSnapshot();
+ * catalog->refresh();
+ * \endcode
+ *
+ * The catalog belongs to the thread it was created in, which has to be the
+ * one of Authority.
+ *
+ * \since 0.201
+ */
+class POLKITQT1_CORE_EXPORT ActionCatalog : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ActionCatalog)
+public:
+    explicit ActionCatalog(QObject *parent = nullptr);
+    ~ActionCatalog() override;
+
+    /**
+     * Enumerates the actions in the background. Does nothing else if a
+     * refresh is running already, except that it is repeated once it finished.
+     *
+     * refreshed() is emitted after the differences have been reported. If the
+     * enumeration fails the catalog keeps its current content.
+     */
+    void refresh();
+
+    /**
+     * Enumerates the actions and blocks until they arrived.
+     *
+     * \return \c false if the enumeration failed. The error state of
+     *         Authority is neither looked at nor changed.
+     */
+    bool refreshSync();
+
+    /**
+     * \return \c true if a refresh is running
+     */
+    bool isRefreshing() const;
+
+    /**
+     * \return \c true once the catalog was filled by a refresh or from the snapshot
+     */
+    bool isLoaded() const;
+
+    /**
+     * Sets whether the catalog refreshes itself when the configuration of
+     * polkitd changes. Enabled by default.
+     */
+    void setAutoRefresh(bool enabled);
+
+    /**
+     * \return \c true if the catalog refreshes itself on configuration changes
+     */
+    bool autoRefresh() const;
+
+    /**
+     * Sets the file that keeps a snapshot of the catalog. Every refresh
+     * that changed the catalog writes it, so loadSnapshot() can fill the
+     * catalog of the next run without asking polkitd. An empty \p fileName
+     * disables the snapshot, which is the default.
+     */
+    void setSnapshotFile(const QString &fileName);
+
+    /**
+     * \return the file that keeps the snapshot of the catalog, if any
+     */
+    QString snapshotFile() const;
+
+    /**
+     * \return a file for the snapshot in the cache directory of the user,
+     *         shared by all programs using polkit-qt
+     */
+    static QString defaultSnapshotFile();
+
+    /**
+     * Fills the catalog from the snapshot file, reporting the differences
+     * like a refresh does. The file is only used if it was written for the
+     * current locale and no .policy file was installed, changed or removed since.
+     * Loading it only maps the file and decodes the action ids, so it is much
+     * faster than asking polkitd.
+     *
+     * As the snapshot may still miss configuration changes of polkitd, follow
+     * this with refresh().
+     *
+     * \return \c false if there is no usable snapshot
+     */
+    bool loadSnapshot();
+
+    /**
+     * \return the number of actions in the catalog
+     */
+    int count() const;
+
+    /**
+     * \return \c true if the catalog holds the action \p actionId
+     */
+    bool contains(const QString &actionId) const;
+
+    /**
+     * \return the action \p actionId, or an ActionDescription with an empty
+     *         action id if the catalog does not hold it
+     */
+    ActionDescription lookup(const QString &actionId) const;
+
+    /**
+     * \return all actions, sorted by action id
+     */
+    ActionDescription::List actions() const;
+
+    /**
+     * \return the ids of all actions, sorted
+     */
+    QStringList actionIds() const;
+
+    /**
+     * Returns the actions whose id starts with \p prefix, sorted by action id.
+     *
+     * A prefix ending in a dot, like \c "org.kde.", selects a namespace. It
+     * takes time proportional to the number of matches, not to the size of
+     * the catalog.
+     */
+    ActionDescription::List actionsWithPrefix(const QString &prefix) const;
+
+Q_SIGNALS:
+    /**
+     * Emitted by a refresh for the actions that appeared since the last one.
+     */
+    void actionsAdded(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * Emitted by a refresh for the actions that disappeared since the last one.
+     */
+    void actionsRemoved(const QStringList &actionIds);
+
+    /**
+     * Emitted by a refresh for the actions whose description changed since
+     * the last one, with their new descriptions.
+     */
+    void actionsChanged(const PolkitQt1::ActionDescription::List &actions);
+
+    /**
+     * Emitted once a refresh finished successfully, after the differences
+     * have been reported.
+     */
+    void refreshed();
+
+private:
+    class Private;
+    Private * const d;
+};
+
+}
+
+#endif
@@ -7,6 +7,7 @@
 */
 
 #include "polkitqt1-actiondescription.h"
+#include "polkitqt1-actiondescription_p.h"
 
 #include <QString>
 
@@ -15,37 +16,6 @@
 namespace PolkitQt1
 {
 
-class Q_DECL_HIDDEN ActionDescription::Data : public QSharedData
-{
-public:
-    Data() {}
-    Data(const Data& other)
-        : QSharedData(other)
-        , actionId(other.actionId)
-        , description(other.description)
-        , message(other.message)
-        , vendorName(other.vendorName)
-        , vendorUrl(other.vendorUrl)
-        , iconName(other.iconName)
-        , implicitAny(other.implicitAny)
-        , implicitInactive(other.implicitInactive)
-        , implicitActive(other.implicitActive)
-    {
-    }
-    virtual ~Data() {}
-
-    QString actionId;
-    QString description;
-    QString message;
-    QString vendorName;
-    QString vendorUrl;
-    QString iconName;
-
-    ActionDescription::ImplicitAuthorization implicitAny;
-    ActionDescription::ImplicitAuthorization implicitInactive;
-    ActionDescription::ImplicitAuthorization implicitActive;
-};
-
 ActionDescription::ActionDescription()
         : d(new Data)
 {
@@ -53,21 +23,15 @@ ActionDescription::ActionDescription()
 }
 
 ActionDescription::ActionDescription(PolkitActionDescription *polkitActionDescription)
-        : d(new Data)
 {
-    d->actionId = QString::fromUtf8(polkit_action_description_get_action_id(polkitActionDescription));
-    d->description = QString::fromUtf8(polkit_action_description_get_description(polkitActionDescription));
-    d->message = QString::fromUtf8(polkit_action_description_get_message(polkitActionDescription));
-    d->vendorName = QString::fromUtf8(polkit_action_description_get_vendor_name(polkitActionDescription));
-    d->vendorUrl = QString::fromUtf8(polkit_action_description_get_vendor_url(polkitActionDescription));
-    d->iconName = QString::fromUtf8(polkit_action_description_get_icon_name(polkitActionDescription));
+    ActionDescriptionListBuilder builder(1);
+    builder.add(polkitActionDescription);
+    d = builder.take().first().d;
+}
 
-    d->implicitAny = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_any(
-                         polkitActionDescription));
-    d->implicitInactive = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_inactive(
-                              polkitActionDescription));
-    d->implicitActive = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_active(
-                            polkitActionDescription));
+ActionDescription::ActionDescription(Data *data)
+        : d(data)
+{
 }
 
 ActionDescription::ActionDescription(const PolkitQt1::ActionDescription& other)
@@ -85,6 +49,27 @@ ActionDescription::~ActionDescription()
 {
 }
 
+bool ActionDescription::operator==(const ActionDescription &other) const
+{
+    if (d == other.d) {
+        return true;
+    }
+
+    return d->actionId == other.d->actionId
+           && d->vendorName == other.d->vendorName
+           && d->vendorUrl == other.d->vendorUrl
+           && d->iconName == other.d->iconName
+           && d->implicitAny == other.d->implicitAny
+           && d->implicitInactive == other.d->implicitInactive
+           && d->implicitActive == other.d->implicitActive
+           && d->sameTexts(*other.d);
+}
+
+bool ActionDescription::operator!=(const ActionDescription &other) const
+{
+    return !(*this == other);
+}
+
 QString ActionDescription::actionId() const
 {
     return d->actionId;
@@ -92,12 +77,12 @@ QString ActionDescription::actionId() const
 
 QString ActionDescription::description() const
 {
-    return d->description;
+    return d->description();
 }
 
 QString ActionDescription::message() const
 {
-    return d->message;
+    return d->message();
 }
 
 QString ActionDescription::vendorName() const
@@ -117,17 +102,125 @@ QString ActionDescription::iconName() const
 
 ActionDescription::ImplicitAuthorization ActionDescription::implicitAny() const
 {
-    return d->implicitAny;
+    return static_cast<ImplicitAuthorization>(d->implicitAny);
 }
 
 ActionDescription::ImplicitAuthorization ActionDescription::implicitInactive() const
 {
-    return d->implicitInactive;
+    return static_cast<ImplicitAuthorization>(d->implicitInactive);
 }
 
 ActionDescription::ImplicitAuthorization ActionDescription::implicitActive() const
 {
-    return d->implicitActive;
+    return static_cast<ImplicitAuthorization>(d->implicitActive);
+}
+
+ActionDescriptionListBuilder::ActionDescriptionListBuilder(int sizeHint)
+{
+    m_data.reserve(sizeHint);
+    // Description and message of an action take a bit more than a hundred bytes together
+    m_texts.reserve(sizeHint * 128);
+}
+
+ActionDescriptionListBuilder::~ActionDescriptionListBuilder()
+{
+    qDeleteAll(m_data);
+}
+
+void ActionDescriptionListBuilder::add(PolkitActionDescription *actionDescription)
+{
+    ActionDescription::Data *data = append(polkit_action_description_get_implicit_any(actionDescription),
+                                           polkit_action_description_get_implicit_inactive(actionDescription),
+                                           polkit_action_description_get_implicit_active(actionDescription));
+    data->actionId = QString::fromUtf8(polkit_action_description_get_action_id(actionDescription));
+    data->vendorName = intern(polkit_action_description_get_vendor_name(actionDescription));
+    data->vendorUrl = intern(polkit_action_description_get_vendor_url(actionDescription));
+    data->iconName = intern(polkit_action_description_get_icon_name(actionDescription));
+
+    const char *description = polkit_action_description_get_description(actionDescription);
+    const char *message = polkit_action_description_get_message(actionDescription);
+    data->descriptionOffset = m_texts.size();
+    data->descriptionSize = description ? qstrlen(description) : 0;
+    m_texts.append(description, data->descriptionSize);
+    data->messageOffset = m_texts.size();
+    data->messageSize = message ? qstrlen(message) : 0;
+    m_texts.append(message, data->messageSize);
+}
+
+void ActionDescriptionListBuilder::add(const QString &actionId, const QString &description, const QString &message,
+                                       const QString &vendorName, const QString &vendorUrl, const QString &iconName,
+                                       int implicitAny, int implicitInactive, int implicitActive)
+{
+    ActionDescription::Data *data = append(implicitAny, implicitInactive, implicitActive);
+    data->actionId = actionId;
+    data->vendorName = intern(vendorName);
+    data->vendorUrl = intern(vendorUrl);
+    data->iconName = intern(iconName);
+
+    data->descriptionOffset = m_texts.size();
+    m_texts.append(description.toUtf8());
+    data->descriptionSize = m_texts.size() - data->descriptionOffset;
+    data->messageOffset = m_texts.size();
+    m_texts.append(message.toUtf8());
+    data->messageSize = m_texts.size() - data->messageOffset;
+}
+
+ActionDescription::List ActionDescriptionListBuilder::take()
+{
+    // One allocation for the texts of all actions
+    m_texts.squeeze();
+
+    ActionDescription::List result;
+    result.reserve(m_data.size());
+    for (ActionDescription::Data *data : m_data) {
+        data->texts = m_texts;
+        result.append(ActionDescription(data));
+    }
+
+    m_data.clear();
+    m_texts.clear();
+    m_utf8Strings.clear();
+    m_strings.clear();
+    return result;
+}
+
+ActionDescription::Data *ActionDescriptionListBuilder::append(int implicitAny, int implicitInactive, int implicitActive)
+{
+    auto data = new ActionDescription::Data;
+    data->implicitAny = implicitAny;
+    data->implicitInactive = implicitInactive;
+    data->implicitActive = implicitActive;
+    m_data.append(data);
+    return data;
+}
+
+QString ActionDescriptionListBuilder::intern(const char *utf8)
+{
+    if (!utf8) {
+        return QString();
+    }
+
+    // Looked up without copying, only a new value is copied into the table
+    const QByteArray key = QByteArray::fromRawData(utf8, qstrlen(utf8));
+    const auto it = m_utf8Strings.constFind(key);
+    if (it != m_utf8Strings.constEnd()) {
+        return it.value();
+    }
+
+    const QString string = QString::fromUtf8(key);
+    m_utf8Strings.insert(QByteArray(key.constData(), key.size()), string);
+    return string;
+}
+
+QString ActionDescriptionListBuilder::intern(const QString &string)
+{
+    const auto it = m_strings.constFind(string);
+    if (it != m_strings.constEnd()) {
+        return *it;
+    }
+
+    m_strings.insert(string);
+    return string;
 }
 
 }
@@ -62,6 +62,18 @@ public:
 
     ActionDescription &operator=(const ActionDescription &other);
 
+    /**
+     * \return \c true if both describe the same action the same way
+     *
+     * \since 0.201
+     */
+    bool operator==(const ActionDescription &other) const;
+
+    /**
+     * \since 0.201
+     */
+    bool operator!=(const ActionDescription &other) const;
+
     /**
      * \brief Gets the action id for ActionDescription
      *
@@ -126,7 +138,13 @@ public:
     ActionDescription::ImplicitAuthorization implicitActive() const;
 
 private:
+    // They fill Data directly, for descriptions not coming from a PolkitActionDescription
+    friend class ActionDescriptionListBuilder;
+    friend class ActionSnapshot;
+
     class Data;
+    explicit ActionDescription(Data *data);
+
     QSharedDataPointer< Data > d;
 };
 }
@@ -0,0 +1,125 @@
+/*
+    This file is part of the Polkit-qt project
+    SPDX-FileCopyrightText: 2009 Jaroslav Reznik <jreznik@redhat.com>
+    SPDX-FileCopyrightText: 2010 Dario Freddi <drf@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_ACTION_DESCRIPTION_P_H
+#define POLKITQT1_ACTION_DESCRIPTION_P_H
+
+#include "polkitqt1-actiondescription.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <cstring>
+
+namespace PolkitQt1
+{
+
+/**
+ * \internal
+ * Every enumeration returns hundreds of actions, and a daemon may keep them
+ * for its whole lifetime. To keep that small the texts shown to the user are
+ * kept as UTF-8 in one block shared by all actions of an enumeration and only
+ * decoded when asked for, while the vendor and icon fields, which repeat
+ * across most actions, share one QString per distinct value.
+ */
+class Q_DECL_HIDDEN ActionDescription::Data : public QSharedData
+{
+public:
+    Data()
+        : descriptionOffset(0)
+        , descriptionSize(0)
+        , messageOffset(0)
+        , messageSize(0)
+        , implicitAny(ActionDescription::Unknown)
+        , implicitInactive(ActionDescription::Unknown)
+        , implicitActive(ActionDescription::Unknown)
+    {
+    }
+
+    QString description() const
+    {
+        return text(descriptionOffset, descriptionSize);
+    }
+
+    QString message() const
+    {
+        return text(messageOffset, messageSize);
+    }
+
+    bool sameTexts(const Data &other) const
+    {
+        return descriptionSize == other.descriptionSize && messageSize == other.messageSize
+               && std::memcmp(texts.constData() + descriptionOffset, other.texts.constData() + other.descriptionOffset, descriptionSize) == 0
+               && std::memcmp(texts.constData() + messageOffset, other.texts.constData() + other.messageOffset, messageSize) == 0;
+    }
+
+    QString actionId;
+    QString vendorName;
+    QString vendorUrl;
+    QString iconName;
+    // UTF-8 of description and message, possibly shared with other actions
+    QByteArray texts;
+    // Owns the memory texts points into if texts does not own it, like a mapped snapshot file
+    QSharedPointer<QObject> textsOwner;
+    int descriptionOffset;
+    int descriptionSize;
+    int messageOffset;
+    int messageSize;
+
+    qint8 implicitAny;
+    qint8 implicitInactive;
+    qint8 implicitActive;
+
+private:
+    QString text(int offset, int size) const
+    {
+        return size > 0 ? QString::fromUtf8(texts.constData() + offset, size) : QString();
+    }
+};
+
+/**
+ * \internal
+ * Builds the ActionDescription::List of one enumeration, putting the texts of
+ * all actions into one block and sharing repeated vendor and icon strings.
+ */
+class Q_DECL_HIDDEN ActionDescriptionListBuilder
+{
+public:
+    explicit ActionDescriptionListBuilder(int sizeHint = 0);
+    ~ActionDescriptionListBuilder();
+
+    void add(PolkitActionDescription *actionDescription);
+    void add(const QString &actionId, const QString &description, const QString &message,
+             const QString &vendorName, const QString &vendorUrl, const QString &iconName,
+             int implicitAny, int implicitInactive, int implicitActive);
+
+    /**
+     * \return the actions added so far, in order. The builder is empty afterwards.
+     */
+    ActionDescription::List take();
+
+private:
+    ActionDescription::Data *append(int implicitAny, int implicitInactive, int implicitActive);
+    QString intern(const char *utf8);
+    QString intern(const QString &string);
+
+    QVector<ActionDescription::Data *> m_data;
+    QByteArray m_texts;
+    QHash<QByteArray, QString> m_utf8Strings;
+    QSet<QString> m_strings;
+
+    Q_DISABLE_COPY(ActionDescriptionListBuilder)
+};
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-actionsnapshot_p.h"
+#include "polkitqt1-actiondescription_p.h"
+#include "polkitqt1-config.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <cstring>
+
+namespace PolkitQt1
+{
+
+namespace
+{
+
+// "PQAS" in the byte order of the writer, so files of another byte order fail the check
+const quint32 s_magic = 0x50514153;
+// Bump whenever the layout below changes
+const quint32 s_version = 2;
+
+// Part of the string block
+struct Span
+{
+    quint32 offset;
+    quint32 size;
+};
+
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    // See actionsFingerprint()
+    quint64 actionsFingerprint;
+    Span locale;
+    quint32 stringCount;
+    quint32 actionCount;
+    quint32 textsSize;
+    quint32 reserved;
+};
+
+struct Record
+{
+    Span actionId;
+    Span description;
+    Span message;
+    // Indexes into the string table
+    quint32 vendorName;
+    quint32 vendorUrl;
+    quint32 iconName;
+    qint8 implicitAny;
+    qint8 implicitInactive;
+    qint8 implicitActive;
+    qint8 reserved;
+};
+
+/**
+ * Hashes the names, modification times and sizes of all .policy files, so
+ * it changes when any of them is added, removed or modified. Package managers
+ * often keep the modification times of the package, so neither the one of
+ * the directory nor the newest one of the files tells an update.
+ */
+quint64 actionsFingerprint()
+{
+    const QFileInfoList infos = QDir(ActionSnapshot::actionDirectory()).entryInfoList(QStringList() << QStringLiteral("*.policy"),
+                                                                                      QDir::Files, QDir::Name);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QFileInfo &info : infos) {
+        hash.addData(QFile::encodeName(info.fileName()) + '\0'
+                     + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '\0'
+                     + QByteArray::number(info.size()) + '\0');
+    }
+
+    quint64 fingerprint;
+    std::memcpy(&fingerprint, hash.result().constData(), sizeof(fingerprint));
+    return fingerprint;
+}
+
+Span appendText(QByteArray *texts, const QByteArray &text)
+{
+    const Span span = {quint32(texts->size()), quint32(text.size())};
+    texts->append(text);
+    return span;
+}
+
+bool isValid(const Span &span, quint32 textsSize)
+{
+    return span.offset <= textsSize && span.size <= textsSize - span.offset;
+}
+
+QString decode(const QByteArray &texts, const Span &span)
+{
+    return span.size > 0 ? QString::fromUtf8(texts.constData() + span.offset, span.size) : QString();
+}
+
+}
+
+bool ActionSnapshot::write(const QString &fileName, const ActionDescription::List &actions)
+{
+    QByteArray texts;
+    QVector<Span> strings;
+    QHash<QString, quint32> stringIndexes;
+    auto stringIndex = [&](const QString &string) {
+        const auto it = stringIndexes.constFind(string);
+        if (it != stringIndexes.constEnd()) {
+            return it.value();
+        }
+        const quint32 index = strings.size();
+        strings.append(appendText(&texts, string.toUtf8()));
+        stringIndexes.insert(string, index);
+        return index;
+    };
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = s_magic;
+    header.version = s_version;
+    header.actionsFingerprint = actionsFingerprint();
+    header.locale = appendText(&texts, QLocale::system().name().toUtf8());
+
+    QVector<Record> records;
+    records.reserve(actions.size());
+    for (const ActionDescription &action : actions) {
+        Record record;
+        std::memset(&record, 0, sizeof(record));
+        record.actionId = appendText(&texts, action.actionId().toUtf8());
+        record.description = appendText(&texts, action.description().toUtf8());
+        record.message = appendText(&texts, action.message().toUtf8());
+        record.vendorName = stringIndex(action.vendorName());
+        record.vendorUrl = stringIndex(action.vendorUrl());
+        record.iconName = stringIndex(action.iconName());
+        record.implicitAny = action.implicitAny();
+        record.implicitInactive = action.implicitInactive();
+        record.implicitActive = action.implicitActive();
+        records.append(record);
+    }
+
+    header.stringCount = strings.size();
+    header.actionCount = records.size();
+    header.textsSize = texts.size();
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(strings.constData()), strings.size() * sizeof(Span));
+    file.write(reinterpret_cast<const char *>(records.constData()), records.size() * sizeof(Record));
+    file.write(texts);
+    return file.commit();
+}
+
+bool ActionSnapshot::read(const QString &fileName, ActionDescription::List *actions)
+{
+    // Stays open, and so mapped, as long as an action points into the mapping
+    const QSharedPointer<QFile> file(new QFile(fileName));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header))) {
+        return false;
+    }
+
+    const uchar *map = file->map(0, file->size());
+    if (!map) {
+        return false;
+    }
+
+    // The fields are copied out instead of cast in place, nothing in the file has to be aligned
+    Header header;
+    std::memcpy(&header, map, sizeof(header));
+    if (header.magic != s_magic || header.version != s_version) {
+        return false;
+    }
+
+    const qint64 stringsStart = sizeof(Header);
+    const qint64 recordsStart = stringsStart + qint64(header.stringCount) * sizeof(Span);
+    const qint64 textsStart = recordsStart + qint64(header.actionCount) * sizeof(Record);
+    if (textsStart + header.textsSize != file->size() || !isValid(header.locale, header.textsSize)) {
+        return false;
+    }
+
+    // Outdated, the current actions have to be enumerated anyway
+    const QByteArray locale = QByteArray::fromRawData(reinterpret_cast<const char *>(map) + textsStart + header.locale.offset,
+                                                      header.locale.size);
+    if (header.actionsFingerprint != actionsFingerprint() || locale != QLocale::system().name().toUtf8()) {
+        return false;
+    }
+
+    // Becomes the shared text block of all actions without a copy, see ActionDescription::Data.
+    // write() replaces the file instead of writing into it, so the mapping never changes.
+    const QByteArray texts = QByteArray::fromRawData(reinterpret_cast<const char *>(map) + textsStart,
+                                                     header.textsSize);
+
+    QVector<QString> strings;
+    strings.reserve(header.stringCount);
+    for (quint32 i = 0; i < header.stringCount; ++i) {
+        Span span;
+        std::memcpy(&span, map + stringsStart + i * sizeof(Span), sizeof(span));
+        if (!isValid(span, header.textsSize)) {
+            return false;
+        }
+        strings.append(decode(texts, span));
+    }
+
+    ActionDescription::List result;
+    result.reserve(header.actionCount);
+    for (quint32 i = 0; i < header.actionCount; ++i) {
+        Record record;
+        std::memcpy(&record, map + recordsStart + i * sizeof(Record), sizeof(record));
+        if (!isValid(record.actionId, header.textsSize) || !isValid(record.description, header.textsSize)
+            || !isValid(record.message, header.textsSize) || record.vendorName >= header.stringCount
+            || record.vendorUrl >= header.stringCount || record.iconName >= header.stringCount) {
+            return false;
+        }
+
+        auto data = new ActionDescription::Data;
+        data->actionId = decode(texts, record.actionId);
+        data->vendorName = strings.at(record.vendorName);
+        data->vendorUrl = strings.at(record.vendorUrl);
+        data->iconName = strings.at(record.iconName);
+        data->texts = texts;
+        data->textsOwner = file;
+        data->descriptionOffset = record.description.offset;
+        data->descriptionSize = record.description.size;
+        data->messageOffset = record.message.offset;
+        data->messageSize = record.message.size;
+        data->implicitAny = record.implicitAny;
+        data->implicitInactive = record.implicitInactive;
+        data->implicitActive = record.implicitActive;
+        result.append(ActionDescription(data));
+    }
+
+    *actions = result;
+    return true;
+}
+
+QString ActionSnapshot::actionDirectory()
+{
+    return QStringLiteral(POLKIT_ACTIONS_DIR);
+}
+
+}
@@ -0,0 +1,55 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_ACTIONSNAPSHOT_P_H
+#define POLKITQT1_ACTIONSNAPSHOT_P_H
+
+#include "polkitqt1-actiondescription.h"
+
+#include <QString>
+
+namespace PolkitQt1
+{
+
+/**
+ * \internal
+ * \brief Binary file holding the actions of one enumeration
+ *
+ * The file starts with a fixed header, followed by a table of the distinct
+ * vendor and icon strings, one fixed size record per action and a block with
+ * the UTF-8 of all strings. read() maps the file and uses the string block in
+ * place as the shared text block of the ActionDescriptions, which keep the
+ * mapping alive, so loading costs little more than decoding the action ids.
+ *
+ * A snapshot is only read back for the locale it was written in, and only
+ * as long as no .policy file was added, removed or modified since it was
+ * written.
+ */
+class Q_DECL_HIDDEN ActionSnapshot
+{
+public:
+    /**
+     * Writes \p actions to \p fileName, replacing it atomically.
+     */
+    static bool write(const QString &fileName, const ActionDescription::List &actions);
+
+    /**
+     * Reads the actions back from \p fileName.
+     *
+     * \return \c false if the file is missing, damaged, written by another
+     *         version or outdated. \p actions is left alone then.
+     */
+    static bool read(const QString &fileName, ActionDescription::List *actions);
+
+    /**
+     * \return the directory polkitd reads the .policy files from
+     */
+    static QString actionDirectory();
+};
+
+}
+
+#endif
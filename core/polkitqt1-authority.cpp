@@ -9,10 +9,37 @@
 */
 
 #include "polkitqt1-authority.h"
-
+#include "polkitqt1-actiondescription_p.h"
+#include "polkitqt1-config.h"
+#include "polkitqt1-conversions_p.h"
+#include "polkitqt1-debug_p.h"
+#include "polkitqt1-statistics_p.h"
+#include "polkitqt1-tracer.h"
+
+#include <QAtomicInt>
+#include <QDBusArgument>
 #include <QDBusInterface>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
 #include <QDBusReply>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFutureInterface>
+#include <QHash>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadStorage>
+#include <QTimer>
+
+#include <functional>
+
+#if USE_QTDBUS_BACKEND
+#include "polkitqt1-dbusauthority_p.h"
+#endif
 
 #include <polkit/polkit.h>
 
@@ -22,17 +49,21 @@ namespace PolkitQt1
 class AuthorityHelper
 {
 public:
-    AuthorityHelper() : q(nullptr) {}
+    AuthorityHelper() : q(nullptr), initAsync(false) {}
     ~AuthorityHelper() {
         delete q;
     }
     Authority *q;
+    QMutex mutex;
+    // Set by instanceAsync() for the Authority it creates
+    bool initAsync;
 };
 
 Q_GLOBAL_STATIC(AuthorityHelper, s_globalAuthority)
 
 Authority *Authority::instance(PolkitAuthority *authority)
 {
+    QMutexLocker locker(&s_globalAuthority()->mutex);
     if (!s_globalAuthority()->q) {
         new Authority(authority);
     }
@@ -40,6 +71,17 @@ Authority *Authority::instance(PolkitAuthority *authority)
     return s_globalAuthority()->q;
 }
 
+Authority *Authority::instanceAsync()
+{
+    QMutexLocker locker(&s_globalAuthority()->mutex);
+    if (!s_globalAuthority()->q) {
+        s_globalAuthority()->initAsync = true;
+        new Authority(nullptr);
+    }
+
+    return s_globalAuthority()->q;
+}
+
 Authority::Result polkitResultToResult(PolkitAuthorizationResult *result)
 {
     if (polkit_authorization_result_get_is_challenge(result)) {
@@ -51,48 +93,153 @@ Authority::Result polkitResultToResult(PolkitAuthorizationResult *result)
     }
 }
 
+Authority::CheckResult polkitResultToCheckResult(PolkitAuthorizationResult *result)
+{
+    Authority::CheckResult res(polkitResultToResult(result));
+    res.temporaryAuthorizationId = QString::fromUtf8(polkit_authorization_result_get_temporary_authorization_id(result));
+    return res;
+}
+
 ActionDescription::List actionsToListAndFree(GList *glist)
 {
-    ActionDescription::List result;
+    ActionDescriptionListBuilder builder(g_list_length(glist));
     for (GList *glist2 = glist; glist2; glist2 = g_list_next(glist2)) {
         gpointer i = glist2->data;
-        result.append(ActionDescription(static_cast<PolkitActionDescription *>(i)));
+        builder.add(static_cast<PolkitActionDescription *>(i));
         g_object_unref(i);
     }
 
+    g_list_free(glist);
+    return builder.take();
+}
+
+TemporaryAuthorization::List temporaryAuthorizationsToListAndFree(GList *glist)
+{
+    TemporaryAuthorization::List result;
+    for (GList *glist2 = glist; glist2; glist2 = g_list_next(glist2)) {
+        result.append(TemporaryAuthorization(static_cast<PolkitTemporaryAuthorization *>(glist2->data)));
+    }
+
     g_list_free(glist);
     return result;
 }
 
+template<typename T>
+QFuture<T> finishedFuture(const T &value)
+{
+    QFutureInterface<T> promise;
+    promise.reportStarted();
+    promise.reportResult(value);
+    promise.reportFinished();
+    return promise.future();
+}
+
 class Q_DECL_HIDDEN Authority::Private
 {
 public:
     // Polkit will return NULL on failures, hence we use it instead of 0
     Private(Authority *qq) : q(qq)
             , pkAuthority(nullptr)
-            , m_hasError(false)
             , m_systemBus(nullptr)
+            , m_cacheMode(Authority::CacheDisabled)
+            , m_cacheHits(0)
+            , m_cacheMisses(0)
+            , m_ready(false)
+            , m_reconnecting(false)
+            , m_polkitLost(false)
+            , m_coalescingInterval(0)
+            , m_coalescingTimer(nullptr)
+            , m_pendingConfigChanged(false)
+            , m_pendingConsoleKitDBChanged(false)
+            , m_changeGeneration(0)
+            , m_useWorkerThread(false)
+            , m_workerThread(nullptr)
+            , m_replyRelay(nullptr)
+            , m_maxInFlightChecks(0)
+            , m_maxQueuedChecks(0)
+            , m_inFlightChecks(0)
+            , m_callTimeout(0)
+            , m_timeoutThread(nullptr)
+#if USE_QTDBUS_BACKEND
+            , dbusAuthority(nullptr)
+#endif
     {
     }
 
     ~Private();
 
-    void init();
+    /**
+     * Connects to polkitd. With \p async set the authority is only looked up
+     * here, authorityReady() finishes the setup once it arrives.
+     */
+    void init(bool async = false);
+    /**
+     * Takes over \p authority, or the error of looking it up, and starts the
+     * calls queued while waiting for it.
+     */
+    void authorityReady(PolkitAuthority *authority, const GError *error);
+    static void getAuthorityCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    /**
+     * Blocks until the authority is connected to polkitd, for the synchronous
+     * methods.
+     */
+    void waitUntilReady();
 
     /** Use this method to set the error message to \p message. Set recover to \c true
-     * to try to reinitialize this object with init() method
+     * to try to reconnect to polkitd with reconnect()
      */
     void setError(Authority::ErrorCode code, const QString &details = QString(), bool recover = false);
 
+    /**
+     * Starts over with a restarted polkitd: clears the error states and the
+     * decision cache, and repeats the lookup of the PolkitAuthority if it
+     * failed. Calls started during the lookup are queued and sent once it is
+     * back. Does nothing while a lookup is running already.
+     */
+    void reconnect();
+    void polkitOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner);
+
     void dbusFilter(const QDBusMessage &message);
+    void loginFilter(const QDBusMessage &message);
     void dbusSignalAdd(const QString &service, const QString &path, const QString &interface, const QString &name);
     void seatSignalsConnect(const QString &seat);
 
+    /**
+     * Returns the decision cache key of the given check, or an empty string if
+     * the check must not be cached.
+     */
+    QString cacheKey(const QString &actionId, const Subject &subject,
+                     Authority::AuthorizationFlags flags, const DetailsMap &details) const;
+    bool cacheLookup(const QString &key, Authority::Result *result);
+    void cacheInsert(const QString &key, const Authority::CheckResult &res);
+
     Authority *q;
     PolkitAuthority *pkAuthority;
-    bool m_hasError;
-    Authority::ErrorCode m_lastError;
-    QString m_errorDetails;
+
+    struct ErrorState
+    {
+        ErrorState() : hasError(false), lastError(E_None), reconnects(0) {}
+
+        bool hasError;
+        Authority::ErrorCode lastError;
+        QString details;
+        // Value of m_reconnects when the error was set
+        int reconnects;
+    };
+    // Each thread sees only the errors of its own calls
+    QThreadStorage<ErrorState> m_errorState;
+    ErrorState &errorState()
+    {
+        ErrorState &state = m_errorState.localData();
+        // Errors from before polkitd restarted went away with it
+        const int reconnects = m_reconnects.loadAcquire();
+        if (state.reconnects != reconnects) {
+            state = ErrorState();
+            state.reconnects = reconnects;
+        }
+        return state;
+    }
+    QAtomicInt m_reconnects;
     // Local system bus. QDBusConnection::systemBus() may only be safely used
     // inside a QCoreApplication scope as for example destruction of connected
     // objects need to happen before the bus disappears. Since this class however
@@ -109,15 +256,251 @@ public:
     *m_enumerateTemporaryAuthorizationsCancellable,
     *m_revokeTemporaryAuthorizationsCancellable,
     *m_revokeTemporaryAuthorizationCancellable;
+    // One per running enumerateActionsChunked() call, so a cancelled call does
+    // not stop the ones started after it, protected by m_mutex
+    QList<GCancellable *> m_chunkedCancellables;
+
+    // Protects the decision cache and the lazily created members below
+    mutable QMutex m_mutex;
+    Authority::CacheMode m_cacheMode;
+    QHash<QString, Authority::Result> m_decisionCache;
+    quint64 m_cacheHits;
+    quint64 m_cacheMisses;
+
+    class WorkerThread;
+    class ReplyRelay;
+    struct ForwardedCall;
+
+    bool m_ready;
+    // Why there is no authority, if looking it up failed
+    QString m_authorityError;
+    // Set while reconnect() looks up the authority again
+    bool m_reconnecting;
+    // Set once polkitd left the bus, so its return is told from its activation
+    bool m_polkitLost;
+    // Calls started before the authority was ready, see startCall()
+    QList<std::function<void()> > m_queuedCalls;
+
+    enum Change {
+        ConfigChange,
+        ConsoleKitDBChange
+    };
+    /**
+     * Reports a change of polkitd, ConsoleKit or logind, right away or once
+     * the burst it belongs to is over.
+     */
+    void notifyChange(Change change);
+    void flushChanges();
+
+    int m_coalescingInterval;
+    QTimer *m_coalescingTimer;
+    // Running since the first change not reported yet
+    QElapsedTimer m_burstTimer;
+    bool m_pendingConfigChanged;
+    bool m_pendingConsoleKitDBChanged;
+    quint64 m_changeGeneration;
+    Statistics m_statistics;
+    bool m_useWorkerThread;
+    // Both created on first use of the worker thread
+    WorkerThread *m_workerThread;
+    ReplyRelay *m_replyRelay;
+
+    /**
+     * Starts an asynchronous polkit-gobject call. \p start issues the call on
+     * the authority with the callback and user data it is given.
+     *
+     * With the worker thread enabled \p start runs in the worker thread and
+     * \p callback is still called in the thread of Authority, through its Qt
+     * event loop. Otherwise \p start runs right away with \p callback. Calls
+     * started before the authority is ready are queued until it is.
+     *
+     * If there is no authority \p start is not run, \p callback is called
+     * with an error in missingAuthorityDomain() instead, so the callbacks
+     * have to finish their calls with finishCall().
+     */
+    void startCall(const std::function<void(PolkitAuthority *, GAsyncReadyCallback, gpointer)> &start,
+                   GAsyncReadyCallback callback, gpointer userData);
+    static void forwardReply(GObject *object, GAsyncResult *result, gpointer user_data);
+
+    // Domain of the error of the calls startCall() could not make
+    static GQuark missingAuthorityDomain();
+
+    /**
+     * Finishes a call started by startCall() with \p finish, or takes the
+     * error of a call it could not make.
+     */
+    template<typename T>
+    static T finishCall(T (*finish)(PolkitAuthority *, GAsyncResult *, GError **), GObject *object,
+                        GAsyncResult *result, GError **error)
+    {
+        if (object == nullptr) {
+            g_task_propagate_boolean(G_TASK(result), error);
+            return T();
+        }
+        return finish((PolkitAuthority *) object, result, error);
+    }
+
+    /**
+     * Returns E_GetAuthority if \p error is the one of a call startCall()
+     * could not make, \p code otherwise.
+     */
+    static Authority::ErrorCode errorCode(const GError *error, Authority::ErrorCode code);
+    /**
+     * Returns \c true if \p error tells that the call was cancelled.
+     */
+    static bool isCancelled(const GError *error);
+
+    /**
+     * \return \c true if looking up the authority failed, so no check can be
+     *         made, with why in \p details
+     */
+    bool authorityMissing(QString *details) const;
+
+    /**
+     * Runs \p start if fewer than m_maxInFlightChecks checks are in flight,
+     * otherwise queues it. \p start returns \c false if it sent no check,
+     * e.g. because the check was cancelled while it waited. Every check sent
+     * has to call checkFinished() once its reply arrived.
+     *
+     * Returns \c false, without running or queueing \p start, if the queue
+     * is full.
+     */
+    bool scheduleCheck(const std::function<bool()> &start);
+    void checkFinished();
+    void startWaitingChecks();
+
+    int m_maxInFlightChecks;
+    int m_maxQueuedChecks;
+    int m_inFlightChecks;
+    // Checks waiting for a free slot, oldest first
+    QQueue<std::function<bool()> > m_waitingChecks;
+
+    class Deadline;
+
+    /**
+     * Returns the context the timeouts of Deadline run in, starting its
+     * thread on first use.
+     */
+    GMainContext *timeoutContext();
+
+    /**
+     * Returns the timeout of a new call in milliseconds, \c 0 for none.
+     * Interactive checks wait for the user and are never timed out.
+     */
+    int callTimeout(Authority::AuthorizationFlags flags = Authority::None) const
+    {
+        return (flags & Authority::AllowUserInteraction) ? 0 : m_callTimeout.loadAcquire();
+    }
+
+    /**
+     * Returns E_Timeout if the call bounded by \p deadline failed because it
+     * expired, \p code otherwise.
+     */
+    static Authority::ErrorCode errorCode(const Deadline &deadline, Authority::ErrorCode code);
+    static QString errorDetails(const Deadline &deadline, const GError *error);
+#if USE_QTDBUS_BACKEND
+    /**
+     * Returns E_Timeout if \p reply is the error of a call that timed out,
+     * \p code otherwise.
+     */
+    static Authority::ErrorCode errorCode(const QDBusMessage &reply, Authority::ErrorCode code);
+
+    /**
+     * Returns the timeout of a new D-Bus call, -1 for the default of QtDBus.
+     */
+    int dbusTimeout() const
+    {
+        return callTimeout() > 0 ? callTimeout() : -1;
+    }
+#endif
+
+    QAtomicInt m_callTimeout;
+    WorkerThread *m_timeoutThread;
+
+#if USE_QTDBUS_BACKEND
+    DBusAuthority *dbusAuthority;
+    // Cancellation ids of the checks started by checkAuthorization() that are still running,
+    // protected by m_mutex
+    QStringList m_pendingCheckIds;
+
+    /**
+     * Calls \p handler with the reply to \p call once it arrives, in the
+     * thread of the authority whatever thread the call was made from.
+     */
+    template<typename Handler>
+    void watchReply(const QDBusPendingCall &call, Handler handler)
+    {
+        // A parent in another thread is not allowed, and the calling thread may have no event loop
+        auto watcher = new QDBusPendingCallWatcher(call);
+        watcher->moveToThread(q->thread());
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [handler](QDBusPendingCallWatcher *watcher) {
+            handler(watcher->reply());
+            watcher->deleteLater();
+        });
+    }
+
+    bool isPendingCheck(const QString &cancellationId) const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_pendingCheckIds.contains(cancellationId);
+    }
 
     /**
-     * \brief Convert a Qt DetailsMap to the lower level PolkitDetails type
+     * Forgets the pending check \p cancellationId.
      *
-     * The returned pointer needs to be freed via g_object_unref when no
-     * longer needed. Returns nullptr if details is empty.
+     * \return \c false if it was not pending, i.e. it was cancelled
+     */
+    bool takePendingCheck(const QString &cancellationId)
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_pendingCheckIds.removeOne(cancellationId);
+    }
+#endif
+
+    /**
+     * User data of the callbacks of the signal based methods
+     */
+    struct SignalCall
+    {
+        Authority *authority;
+        Statistics::Timer timer;
+    };
+
+    /**
+     * User data of the callback of enumerateActionsChunked()
+     */
+    struct ChunkedCall
+    {
+        Authority *authority;
+        Statistics::Timer timer;
+        int chunkSize;
+        GCancellable *cancellable;
+    };
+
+    /**
+     * Creates the cancellable of a new enumerateActionsChunked() call
      */
-    static PolkitDetails* convertDetailsMap(const DetailsMap &details);
+    GCancellable *startChunked();
+    /**
+     * Ends the enumerateActionsChunked() call of \p cancellable with
+     * enumerateActionsChunkedFinished()
+     */
+    void finishChunked(GCancellable *cancellable, Authority::ErrorCode error);
+
+    /**
+     * Adds the next action of an enumeration to the builder, returns false
+     * after the last one
+     */
+    typedef std::function<bool(ActionDescriptionListBuilder *)> ActionReader;
+
+    /**
+     * Converts and emits one chunk of actions, then returns to the event loop
+     * before the next one, so receivers can show them in between
+     */
+    void emitActionChunks(const QSharedPointer<ActionReader> &reader, int chunkSize, GCancellable *cancellable);
+
     static void pk_config_changed();
+    static void enumerateActionsChunkedCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void checkAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void enumerateActionsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void registerAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data);
@@ -126,381 +509,2289 @@ public:
     static void enumerateTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void revokeTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data);
     static void revokeTemporaryAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data);
-};
-
-Authority::Private::~Private()
-{
-    delete m_systemBus;
-    g_object_unref(m_checkAuthorizationCancellable);
-    g_object_unref(m_enumerateActionsCancellable);
-    g_object_unref(m_registerAuthenticationAgentCancellable);
-    g_object_unref(m_unregisterAuthenticationAgentCancellable);
-    g_object_unref(m_authenticationAgentResponseCancellable);
-    g_object_unref(m_enumerateTemporaryAuthorizationsCancellable);
-    g_object_unref(m_revokeTemporaryAuthorizationsCancellable);
-    g_object_unref(m_revokeTemporaryAuthorizationCancellable);
-}
 
-Authority::Authority(PolkitAuthority *authority, QObject *parent)
-        : QObject(parent)
-        , d(new Private(this))
-{
-    qRegisterMetaType<PolkitQt1::Authority::Result> ();
-    qRegisterMetaType<PolkitQt1::ActionDescription::List>();
+    template<typename T> class AsyncCall;
 
-    Q_ASSERT(!s_globalAuthority()->q);
-    s_globalAuthority()->q = this;
+    /**
+     * Performs a synchronous check. Errors are returned with the result, the
+     * error state is left alone.
+     */
+    Authority::CheckResult checkAuthorizationSync(const QString &actionId, const Subject &subject,
+                                                  Authority::AuthorizationFlags flags, const DetailsMap &details,
+                                                  PolkitDetails *prepared = nullptr);
+    /**
+     * Starts a check reporting through checkAuthorizationFinished(). \p prepared,
+     * if given, is \p details already converted by Details.
+     */
+    void checkAuthorizationWithDetails(const QString &actionId, const Subject &subject,
+                                       Authority::AuthorizationFlags flags, const DetailsMap &details,
+                                       PolkitDetails *prepared);
+    /**
+     * \return a new reference to \p details converted for polkit-gobject, or to \p prepared if given
+     */
+    static PolkitDetails *polkitDetails(const DetailsMap &details, PolkitDetails *prepared);
+    /**
+     * Starts an asynchronous check and calls \p done with its outcome, in the
+     * thread of the authority. The check is cancelled through the cancellable
+     * of \p deadline, which has to outlive it. The error state is left alone.
+     */
+    void startCheck(const QString &actionId, const Subject &subject, Authority::AuthorizationFlags flags,
+                    const DetailsMap &details, const Deadline &deadline, const QString &cancellationId,
+                    const std::function<void(const Authority::CheckResult &)> &done);
+    static Authority::CheckResult checkAuthorizationFinish(GObject *object, GAsyncResult *result);
+#if USE_QTDBUS_BACKEND
+    static Authority::CheckResult checkAuthorizationReply(const QDBusMessage &reply);
+#endif
 
-    if (authority) {
-        d->pkAuthority = authority;
-    }
+    /**
+     * Enumerates the actions synchronously. Errors are returned with the
+     * actions, the error state is left alone.
+     */
+    Authority::ActionsResult enumerateActionsSync();
+    /**
+     * Starts an asynchronous enumeration and calls \p done with its outcome,
+     * like startCheck().
+     */
+    void startEnumeration(const Deadline &deadline, const std::function<void(const Authority::ActionsResult &)> &done);
 
-    d->init();
-}
+    static void checkAuthorizationAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void enumerateActionsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void registerAuthenticationAgentAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void unregisterAuthenticationAgentAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void authenticationAgentResponseAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void enumerateTemporaryAuthorizationsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void revokeTemporaryAuthorizationsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+    static void revokeTemporaryAuthorizationAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data);
 
-Authority::~Authority()
-{
-    if (d->pkAuthority != nullptr) {
-        g_object_unref(d->pkAuthority);
-    }
+    class BatchCall;
+    struct BatchItem;
 
-    delete d;
-}
+    /**
+     * Issues all checks of \p batch at once. Checks answered from the decision
+     * cache or rejected up front are filled in immediately, batch->pending counts
+     * the ones still waiting for polkitd.
+     */
+    void startBatch(BatchCall *batch, const QList<Authority::CheckRequest> &requests,
+                    Authority::AuthorizationFlags flags, const Deadline &deadline);
+    /**
+     * Records the outcome of one check of \p batch and completes the batch
+     * if it was the last check still running.
+     */
+    void batchCheckFinished(BatchCall *batch, int index, const Authority::CheckResult &result);
+    /**
+     * Returns \c true if any check of a batch failed, which counts the batch
+     * as failed in the statistics.
+     */
+    static bool batchFailed(const QVector<Authority::CheckResult> &results);
+    static void checkAuthorizationBatchCallback(GObject *object, GAsyncResult *result, gpointer user_data);
+};
 
-void Authority::Private::init()
+/**
+ * \internal
+ * Bounds the time a single call may take, see Authority::setCallTimeout().
+ *
+ * Once the timeout passed the cancellable of the call is cancelled from a
+ * thread of its own, so synchronous calls blocking the thread of the caller
+ * are interrupted as well.
+ */
+class Authority::Private::Deadline
 {
-    QDBusError error;
-    QDBusError dbus_error;
-
-    m_systemBus = new QDBusConnection(QDBusConnection::connectToBus(QDBusConnection::SystemBus,
-                                                                    QStringLiteral("polkit_qt_system_bus")));
+public:
+    /**
+     * Starts the timeout of a call cancelled through \p cancellable, or
+     * through a new cancellable if it is \c nullptr. A \p msec of \c 0 never
+     * expires and does not create a cancellable.
+     */
+    Deadline(Authority::Private *d, int msec, GCancellable *cancellable = nullptr);
+    ~Deadline();
 
-    m_checkAuthorizationCancellable = g_cancellable_new();
-    m_enumerateActionsCancellable = g_cancellable_new();
-    m_registerAuthenticationAgentCancellable = g_cancellable_new();
-    m_unregisterAuthenticationAgentCancellable = g_cancellable_new();
-    m_authenticationAgentResponseCancellable = g_cancellable_new();
-    m_enumerateTemporaryAuthorizationsCancellable = g_cancellable_new();
-    m_revokeTemporaryAuthorizationsCancellable = g_cancellable_new();
-    m_revokeTemporaryAuthorizationCancellable = g_cancellable_new();
+    GCancellable *cancellable() const
+    {
+        return m_state->cancellable;
+    }
 
-#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
-    GError *gerror = nullptr;
-#endif
-    if (pkAuthority == nullptr) {
-#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
-        pkAuthority = polkit_authority_get_sync(nullptr, &gerror);
-        if (gerror != nullptr) {
-            setError(E_GetAuthority, gerror->message);
-            g_error_free(gerror);
-            return;
-        }
-#else
-        pkAuthority = polkit_authority_get();
-#endif
+    bool hasExpired() const
+    {
+        return m_state->expired.loadAcquire();
     }
 
-    if (pkAuthority == nullptr) {
-#ifdef POLKIT_QT_1_COMPATIBILITY_MODE
-        (E_GetAuthority);
-#endif
-        return;
+    /**
+     * Returns the time left in milliseconds, as timeout of a D-Bus call sent
+     * now, or -1 if the call has no timeout.
+     */
+    int remainingTime() const
+    {
+        return m_msec > 0 ? qMax<int>(1, m_msec - m_elapsed.elapsed()) : -1;
     }
 
-    // connect changed signal
-    g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
+private:
+    Q_DISABLE_COPY(Deadline)
 
-    // need to listen to NameOwnerChanged
-    dbusSignalAdd("org.freedesktop.DBus", "/", "org.freedesktop.DBus", "NameOwnerChanged");
+    // Shared with the timeout, which may still run once the call is gone
+    struct State
+    {
+        explicit State(GCancellable *cancellable) : cancellable(cancellable) {}
+        ~State()
+        {
+            if (cancellable != nullptr) {
+                g_object_unref(cancellable);
+            }
+        }
 
-    QString consoleKitService("org.freedesktop.ConsoleKit");
-    QString consoleKitManagerPath("/org/freedesktop/ConsoleKit/Manager");
-    QString consoleKitManagerInterface("org.freedesktop.ConsoleKit.Manager");
+        GCancellable *cancellable;
+        QAtomicInt expired;
+    };
 
-    // first, add signals SeadAdded and SeatRemoved from ConsoleKit Manager
-    dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatAdded");
-    dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatRemoved");
+    static gboolean expire(gpointer data);
+    static void destroy(gpointer data);
 
-    // then we need to extract all seats from ConsoleKit
-    QDBusMessage msg = QDBusMessage::createMethodCall(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "GetSeats");
-    const QDBusMessage reply = m_systemBus->call(msg);
-
-    if (reply.type() != QDBusMessage::ErrorMessage && !reply.arguments().isEmpty()) {
-        // this method returns a list with present seats
-        QStringList seats;
-        QVariant arg = reply.arguments()[0];
-        if (arg.type() == qMetaTypeId<QDBusArgument>()) {
-            arg.value<QDBusArgument>() >> seats;
-        } else {
-            seats = arg.toStringList();
-        }
-        // it can be multiple seats present so connect all their signals
-        Q_FOREACH(const QString &seat, seats) {
-            seatSignalsConnect(seat);
-        }
-    }
-}
+    QSharedPointer<State> m_state;
+    GSource *m_source;
+    int m_msec;
+    QElapsedTimer m_elapsed;
+};
 
-void Authority::Private::setError(Authority::ErrorCode code, const QString &details, bool recover)
-{
-    if (recover) {
-        init();
-    }
-    m_lastError = code;
-    m_errorDetails = details;
-    m_hasError = true;
-}
+static const char s_timeoutMessage[] = "The call did not finish before its timeout";
 
-void Authority::Private::seatSignalsConnect(const QString &seat)
+/**
+ * Returns the value reported by a QFuture based call that timed out, and sets
+ * E_Timeout as error unless the value carries it itself.
+ */
+template<typename T>
+static T timedOutValue(Authority::Private *d, const T &value)
 {
-    QString consoleKitService("org.freedesktop.ConsoleKit");
-    QString consoleKitSeatInterface("org.freedesktop.ConsoleKit.Seat");
-    // we want to connect to all slots of the seat
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceAdded");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceRemoved");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionAdded");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionRemoved");
-    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "ActiveSessionChanged");
+    d->setError(Authority::E_Timeout, QLatin1String(s_timeoutMessage));
+    return value;
 }
 
-void Authority::Private::dbusSignalAdd(const QString &service, const QString &path, const QString &interface, const QString &name)
+static Authority::CheckResult timedOutValue(Authority::Private *, const Authority::CheckResult &)
 {
-    // FIXME: This code seems to be nonfunctional - it needs to be fixed somewhere (is it Qt BUG?)
-    m_systemBus->connect(service, path, interface, name, q, SLOT(dbusFilter(QDBusMessage)));
+    return Authority::CheckResult(Authority::Unknown, Authority::E_Timeout, QLatin1String(s_timeoutMessage));
 }
 
-void Authority::Private::dbusFilter(const QDBusMessage &message)
+static Authority::ActionsResult timedOutValue(Authority::Private *, const Authority::ActionsResult &)
 {
-    if (message.type() == QDBusMessage::SignalMessage) {
-        Q_EMIT q->consoleKitDBChanged();
-
-        // TODO: Test this with the multiseat support
-        if (message.member() == "SeatAdded") {
-            seatSignalsConnect(message.arguments()[0].value<QDBusObjectPath>().path());
-        }
-    }
+    return Authority::ActionsResult(ActionDescription::List(), Authority::E_Timeout, QLatin1String(s_timeoutMessage));
 }
 
-bool Authority::hasError() const
+// The checks of a batch that timed out already report it, see batchCheckFinished()
+static QVector<Authority::CheckResult> timedOutValue(Authority::Private *, const QVector<Authority::CheckResult> &results)
 {
-    return d->m_hasError;
+    return results;
 }
 
-Authority::ErrorCode Authority::lastError() const
+/**
+ * \internal
+ * State of a single call made through one of the QFuture based methods.
+ *
+ * Every call owns its GCancellable, which is cancelled together with the
+ * future handed out to the caller, so calls never interfere with each other.
+ * The object deletes itself once the result has been reported.
+ */
+template<typename T>
+class Authority::Private::AsyncCall
 {
-    return d->m_lastError;
-}
+public:
+    AsyncCall(Authority::Private *dd, Authority::Operation operation, int timeout)
+        : d(dd)
+        , cancellable(g_cancellable_new())
+        , deadline(dd, timeout, cancellable)
+        , failed(false)
+        , timer(dd->m_statistics.start(operation))
+    {
+        promise.reportStarted();
+        // The reply may come from another thread than the caller's one, keep
+        // the watcher where it is handled and deleted
+        watcher.moveToThread(d->q->thread());
+        QObject::connect(&watcher, &QFutureWatcherBase::canceled, [this]() {
+            g_cancellable_cancel(cancellable);
+#if USE_QTDBUS_BACKEND
+            if (!cancellationId.isEmpty()) {
+                d->dbusAuthority->cancelCheckAuthorization(cancellationId);
+            }
+#endif
+        });
+        watcher.setFuture(promise.future());
+    }
 
-const QString Authority::errorDetails() const
+    ~AsyncCall()
+    {
+        g_object_unref(cancellable);
+    }
+
+    QFuture<T> future()
+    {
+        return promise.future();
+    }
+
+    bool isCancelled() const
+    {
+        return g_cancellable_is_cancelled(cancellable);
+    }
+
+    void finish(const T &value)
+    {
+        // The deadline cancels the call, but not the future of the caller
+        const bool timedOut = deadline.hasExpired() && !promise.isCanceled();
+        timer.finish(timedOut ? Statistics::Failed
+                     : isCancelled() ? Statistics::Cancelled : failed ? Statistics::Failed : Statistics::Succeeded);
+        if (timedOut) {
+            promise.reportResult(timedOutValue(d, value));
+        } else if (isCancelled()) {
+            promise.reportCanceled();
+        } else {
+            promise.reportResult(value);
+        }
+        promise.reportFinished();
+        delete this;
+    }
+
+    void fail(Authority::ErrorCode code, const QString &details, const T &value)
+    {
+        // We don't want to set error if this is cancellation of the call
+        if (!isCancelled()) {
+            d->setError(code, details);
+        }
+        failed = true;
+        finish(value);
+    }
+
+    Authority::Private *d;
+    GCancellable *cancellable;
+    Deadline deadline;
+    // Counted as an error by the statistics, set by fail()
+    bool failed;
+    // Decision cache entry to fill in once the result is known, if any
+    QString cacheKey;
+#if USE_QTDBUS_BACKEND
+    // Sent to polkitd with CancelCheckAuthorization when the future is cancelled
+    QString cancellationId;
+#endif
+
+private:
+    Statistics::Timer timer;
+    QFutureInterface<T> promise;
+    QFutureWatcher<T> watcher;
+};
+
+/**
+ * \internal
+ * Results of one checkAuthorizationBatch() call, shared by all of its checks.
+ */
+class Authority::Private::BatchCall
+{
+public:
+    BatchCall(Authority::Private *dd, int count)
+        : d(dd)
+        , results(count)
+        , cacheKeys(count)
+        , pending(0)
+        , call(nullptr)
+        , deadline(nullptr)
+    {
+    }
+
+    Authority::Private *d;
+    QVector<Authority::CheckResult> results;
+    QVector<QString> cacheKeys;
+    int pending;
+    // Only set for asynchronous batches, which report through its future
+    AsyncCall<QVector<Authority::CheckResult> > *call;
+    // Bounds all checks of the batch, set by startBatch()
+    const Deadline *deadline;
+#if USE_QTDBUS_BACKEND
+    // Checks of synchronous batches still waiting for a reply, by index
+    QList<QPair<int, QDBusPendingCall> > dbusCalls;
+#endif
+};
+
+struct Authority::Private::BatchItem
+{
+    BatchCall *batch;
+    int index;
+};
+
+/**
+ * \internal
+ * Thread driving a private GLib main context. Polkit-gobject calls issued from
+ * it complete in that context, independently of the event dispatcher of the
+ * thread Authority lives in.
+ */
+class Authority::Private::WorkerThread : public QThread
+{
+public:
+    WorkerThread()
+        : m_context(g_main_context_new())
+        , m_loop(g_main_loop_new(m_context, FALSE))
+    {
+    }
+
+    ~WorkerThread() override
+    {
+        // Quitting through the context also works if run() did not start yet
+        GMainLoop *loop = m_loop;
+        dispatch([loop]() {
+            g_main_loop_quit(loop);
+        });
+        wait();
+        g_main_loop_unref(m_loop);
+        g_main_context_unref(m_context);
+    }
+
+    /**
+     * Runs \p function in the worker thread, with its context as thread-default.
+     */
+    void dispatch(const std::function<void()> &function)
+    {
+        g_main_context_invoke_full(m_context, G_PRIORITY_DEFAULT, invoke,
+                                   new std::function<void()>(function), destroy);
+    }
+
+    GMainContext *context() const
+    {
+        return m_context;
+    }
+
+protected:
+    void run() override
+    {
+        g_main_context_push_thread_default(m_context);
+        g_main_loop_run(m_loop);
+        g_main_context_pop_thread_default(m_context);
+    }
+
+private:
+    static gboolean invoke(gpointer data)
+    {
+        (*static_cast<std::function<void()> *>(data))();
+        return G_SOURCE_REMOVE;
+    }
+
+    static void destroy(gpointer data)
+    {
+        delete static_cast<std::function<void()> *>(data);
+    }
+
+    GMainContext *m_context;
+    GMainLoop *m_loop;
+};
+
+/**
+ * \internal
+ * Lives in the thread of Authority and runs the callbacks posted to it by the
+ * worker thread.
+ */
+class Authority::Private::ReplyRelay : public QObject
+{
+public:
+    class ReplyEvent : public QEvent
+    {
+    public:
+        explicit ReplyEvent(const std::function<void()> &function)
+            : QEvent(QEvent::User)
+            , function(function)
+        {
+        }
+
+        std::function<void()> function;
+    };
+
+protected:
+    void customEvent(QEvent *event) override
+    {
+        static_cast<ReplyEvent *>(event)->function();
+    }
+};
+
+struct Authority::Private::ForwardedCall
+{
+    ReplyRelay *relay;
+    GAsyncReadyCallback callback;
+    gpointer userData;
+};
+
+Authority::Private::Deadline::Deadline(Authority::Private *d, int msec, GCancellable *cancellable)
+    : m_source(nullptr)
+    , m_msec(msec)
+{
+    if (cancellable != nullptr) {
+        g_object_ref(cancellable);
+    } else if (msec > 0) {
+        cancellable = g_cancellable_new();
+    }
+    m_state = QSharedPointer<State>::create(cancellable);
+
+    if (msec > 0) {
+        m_elapsed.start();
+        m_source = g_timeout_source_new(msec);
+        g_source_set_callback(m_source, expire, new QSharedPointer<State>(m_state), destroy);
+        g_source_attach(m_source, d->timeoutContext());
+    }
+}
+
+Authority::Private::Deadline::~Deadline()
+{
+    if (m_source != nullptr) {
+        g_source_destroy(m_source);
+        g_source_unref(m_source);
+    }
+}
+
+gboolean Authority::Private::Deadline::expire(gpointer data)
+{
+    const QSharedPointer<State> &state = *static_cast<QSharedPointer<State> *>(data);
+    qCDebug(POLKITQT1_CORE, "call timed out");
+    state->expired.storeRelease(1);
+    g_cancellable_cancel(state->cancellable);
+    return G_SOURCE_REMOVE;
+}
+
+void Authority::Private::Deadline::destroy(gpointer data)
+{
+    delete static_cast<QSharedPointer<State> *>(data);
+}
+
+Authority::ErrorCode Authority::Private::errorCode(const Deadline &deadline, Authority::ErrorCode code)
+{
+    return deadline.hasExpired() ? E_Timeout : code;
+}
+
+QString Authority::Private::errorDetails(const Deadline &deadline, const GError *error)
+{
+    // The cancellation error would not tell why the call was cancelled
+    return deadline.hasExpired() ? QString::fromLatin1(s_timeoutMessage) : QString::fromUtf8(error->message);
+}
+
+Authority::ErrorCode Authority::Private::errorCode(const GError *error, Authority::ErrorCode code)
+{
+    return error->domain == missingAuthorityDomain() ? E_GetAuthority : code;
+}
+
+bool Authority::Private::isCancelled(const GError *error)
+{
+    return g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+}
+
+#if USE_QTDBUS_BACKEND
+Authority::ErrorCode Authority::Private::errorCode(const QDBusMessage &reply, Authority::ErrorCode code)
+{
+    return DBusAuthority::isTimeout(QDBusError(reply)) ? E_Timeout : code;
+}
+#endif
+
+GMainContext *Authority::Private::timeoutContext()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_timeoutThread == nullptr) {
+        m_timeoutThread = new WorkerThread;
+        m_timeoutThread->start();
+    }
+    return m_timeoutThread->context();
+}
+
+Authority::Private::~Private()
+{
+#if USE_QTDBUS_BACKEND
+    delete dbusAuthority;
+#endif
+    delete m_workerThread;
+    delete m_timeoutThread;
+    delete m_replyRelay;
+    delete m_systemBus;
+    g_object_unref(m_checkAuthorizationCancellable);
+    g_object_unref(m_enumerateActionsCancellable);
+    g_object_unref(m_registerAuthenticationAgentCancellable);
+    g_object_unref(m_unregisterAuthenticationAgentCancellable);
+    g_object_unref(m_authenticationAgentResponseCancellable);
+    g_object_unref(m_enumerateTemporaryAuthorizationsCancellable);
+    g_object_unref(m_revokeTemporaryAuthorizationsCancellable);
+    g_object_unref(m_revokeTemporaryAuthorizationCancellable);
+}
+
+Authority::Authority(PolkitAuthority *authority, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this))
+{
+    qRegisterMetaType<PolkitQt1::Authority::Result> ();
+    qRegisterMetaType<PolkitQt1::ActionDescription::List>();
+    qRegisterMetaType<PolkitQt1::Authority::LoginChange>();
+    qRegisterMetaType<PolkitQt1::Authority::ErrorCode>();
+
+    Q_ASSERT(!s_globalAuthority()->q);
+    s_globalAuthority()->q = this;
+
+    if (authority) {
+        d->pkAuthority = authority;
+    }
+
+    d->init(s_globalAuthority()->initAsync);
+}
+
+Authority::~Authority()
+{
+    if (d->pkAuthority != nullptr) {
+        g_object_unref(d->pkAuthority);
+    }
+
+    delete d;
+}
+
+void Authority::Private::init(bool async)
+{
+    QDBusError error;
+    QDBusError dbus_error;
+
+    m_systemBus = new QDBusConnection(QDBusConnection::connectToBus(QDBusConnection::SystemBus,
+                                                                    QStringLiteral("polkit_qt_system_bus")));
+
+    m_checkAuthorizationCancellable = g_cancellable_new();
+    m_enumerateActionsCancellable = g_cancellable_new();
+    m_registerAuthenticationAgentCancellable = g_cancellable_new();
+    m_unregisterAuthenticationAgentCancellable = g_cancellable_new();
+    m_authenticationAgentResponseCancellable = g_cancellable_new();
+    m_enumerateTemporaryAuthorizationsCancellable = g_cancellable_new();
+    m_revokeTemporaryAuthorizationsCancellable = g_cancellable_new();
+    m_revokeTemporaryAuthorizationCancellable = g_cancellable_new();
+
+#if USE_QTDBUS_BACKEND
+    // polkit-gobject is only loaded on demand by the authentication agent
+    // methods, see Authority::polkitAuthority()
+    delete dbusAuthority;
+    dbusAuthority = new DBusAuthority(*m_systemBus);
+    dbusAuthority->connectChanged(q, SLOT(dbusFilter(QDBusMessage)));
+    Q_UNUSED(async)
+    authorityReady(pkAuthority, nullptr);
+#else
+    if (pkAuthority != nullptr) {
+        authorityReady(pkAuthority, nullptr);
+    } else if (async) {
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+        polkit_authority_get_async(nullptr, getAuthorityCallback, this);
+#else
+        waitUntilReady();
+#endif
+    } else {
+        waitUntilReady();
+    }
+#endif
+
+    // need to listen to NameOwnerChanged
+    dbusSignalAdd("org.freedesktop.DBus", "/", "org.freedesktop.DBus", "NameOwnerChanged");
+
+    // Reconnect once polkitd restarted, e.g. by a package upgrade
+    m_systemBus->connect(QStringLiteral("org.freedesktop.DBus"), QStringLiteral("/org/freedesktop/DBus"),
+                         QStringLiteral("org.freedesktop.DBus"), QStringLiteral("NameOwnerChanged"),
+                         QStringList() << QStringLiteral("org.freedesktop.PolicyKit1"), QString(),
+                         q, SLOT(polkitOwnerChanged(QString,QString,QString)));
+
+    // logind: one match rule for its manager and one for the property changes
+    // of all its objects, no matter how many seats and sessions there are
+    const QString login1Service = QStringLiteral("org.freedesktop.login1");
+    m_systemBus->connect(login1Service, QStringLiteral("/org/freedesktop/login1"),
+                         QStringLiteral("org.freedesktop.login1.Manager"), QString(),
+                         q, SLOT(loginFilter(QDBusMessage)));
+    m_systemBus->connect(login1Service, QString(),
+                         QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("PropertiesChanged"),
+                         q, SLOT(loginFilter(QDBusMessage)));
+
+    QString consoleKitService("org.freedesktop.ConsoleKit");
+    QString consoleKitManagerPath("/org/freedesktop/ConsoleKit/Manager");
+    QString consoleKitManagerInterface("org.freedesktop.ConsoleKit.Manager");
+
+    // first, add signals SeadAdded and SeatRemoved from ConsoleKit Manager
+    dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatAdded");
+    dbusSignalAdd(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "SeatRemoved");
+
+    // then we need to extract all seats from ConsoleKit, without waiting
+    // for it as it is usually not running anymore
+    QDBusMessage msg = QDBusMessage::createMethodCall(consoleKitService, consoleKitManagerPath, consoleKitManagerInterface, "GetSeats");
+    auto watcher = new QDBusPendingCallWatcher(m_systemBus->asyncCall(msg), q);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, q, [this](QDBusPendingCallWatcher *watcher) {
+        const QDBusMessage reply = watcher->reply();
+        watcher->deleteLater();
+
+        if (reply.type() != QDBusMessage::ErrorMessage && !reply.arguments().isEmpty()) {
+            // this method returns a list with present seats
+            QStringList seats;
+            QVariant arg = reply.arguments()[0];
+            if (arg.type() == qMetaTypeId<QDBusArgument>()) {
+                arg.value<QDBusArgument>() >> seats;
+            } else {
+                seats = arg.toStringList();
+            }
+            // it can be multiple seats present so connect all their signals
+            Q_FOREACH(const QString &seat, seats) {
+                seatSignalsConnect(seat);
+            }
+        }
+    });
+}
+
+void Authority::Private::authorityReady(PolkitAuthority *authority, const GError *error)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_ready) {
+        // A synchronous call did not wait for the asynchronous lookup, we
+        // already hold a reference from it
+        if (authority != nullptr) {
+            g_object_unref(authority);
+        }
+        return;
+    }
+
+    m_ready = true;
+    pkAuthority = authority;
+    m_authorityError = error != nullptr ? QString::fromUtf8(error->message) : QString();
+    const bool reconnected = m_reconnecting;
+    m_reconnecting = false;
+    const QList<std::function<void()> > queuedCalls = m_queuedCalls;
+    m_queuedCalls.clear();
+    locker.unlock();
+
+    if (error != nullptr) {
+        qCWarning(POLKITQT1_CORE) << "Cannot get authority:" << error->message;
+        setError(E_GetAuthority, QString::fromUtf8(error->message));
+    }
+    qCDebug(POLKITQT1_CORE, "authority ready queued_calls=%d", queuedCalls.size());
+#if !USE_QTDBUS_BACKEND
+    if (pkAuthority != nullptr) {
+        // connect changed signal
+        g_signal_connect(G_OBJECT(pkAuthority), "changed", G_CALLBACK(pk_config_changed), NULL);
+    }
+#endif
+
+    for (const auto &call : queuedCalls) {
+        call();
+    }
+
+    // Queued, so that it also reaches whoever connects right after instanceAsync()
+    QMetaObject::invokeMethod(q, reconnected ? "reconnected" : "ready", Qt::QueuedConnection);
+}
+
+void Authority::Private::getAuthorityCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    Q_UNUSED(object)
+    auto d = static_cast<Authority::Private *>(user_data);
+    GError *error = nullptr;
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+    PolkitAuthority *authority = polkit_authority_get_finish(result, &error);
+#else
+    Q_UNUSED(result)
+    PolkitAuthority *authority = nullptr;
+#endif
+    d->authorityReady(authority, error);
+    if (error != nullptr) {
+        g_error_free(error);
+    }
+}
+
+void Authority::Private::waitUntilReady()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_ready) {
+            return;
+        }
+    }
+
+    GError *error = nullptr;
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+    PolkitAuthority *authority = polkit_authority_get_sync(nullptr, &error);
+#else
+    PolkitAuthority *authority = polkit_authority_get();
+#endif
+    authorityReady(authority, error);
+    if (error != nullptr) {
+        g_error_free(error);
+    }
+}
+
+void Authority::Private::setError(Authority::ErrorCode code, const QString &details, bool recover)
+{
+    qCDebug(POLKITQT1_CORE) << "error" << code << details;
+    ErrorState &state = errorState();
+    state.lastError = code;
+    state.details = details;
+    state.hasError = true;
+
+    if (recover) {
+        // Errors may be set from any thread, reconnect() belongs to the one of the authority
+        QMetaObject::invokeMethod(q, "reconnect", Qt::QueuedConnection);
+    }
+}
+
+void Authority::Private::reconnect()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_ready) {
+        // Still looking up the authority, it will be the new one anyway
+        return;
+    }
+    // A PolkitAuthority we have is kept, not rebuilt: polkit_authority_get_async()
+    // returns a singleton that lives as long as anybody, e.g. a running call,
+    // holds a reference, so looking it up again would mostly return the same
+    // object. It does not have to be replaced either, its GDBusProxy follows
+    // the owner of org.freedesktop.PolicyKit1 and sends every call to the
+    // polkitd running now. Only a failed lookup is repeated.
+    const bool lookup = pkAuthority == nullptr;
+    if (lookup) {
+        m_ready = false;
+        m_reconnecting = true;
+    }
+    locker.unlock();
+
+    const int reconnects = m_reconnects.fetchAndAddOrdered(1) + 1;
+    qCInfo(POLKITQT1_CORE, "reconnecting to polkitd reconnects=%d lookup=%d", reconnects, lookup);
+    Tracer::instantEvent("authority", "reconnect");
+
+    // The new polkitd may decide differently, e.g. after an upgrade
+    notifyChange(ConfigChange);
+
+    if (!lookup) {
+        QMetaObject::invokeMethod(q, "reconnected", Qt::QueuedConnection);
+        return;
+    }
+
+#if USE_QTDBUS_BACKEND
+    // polkitAuthority() repeats the lookup of the polkit-gobject object on demand
+    authorityReady(nullptr, nullptr);
+#elif !defined(POLKIT_QT_1_COMPATIBILITY_MODE)
+    polkit_authority_get_async(nullptr, getAuthorityCallback, this);
+#else
+    waitUntilReady();
+#endif
+}
+
+void Authority::Private::polkitOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner)
+{
+    Q_UNUSED(name)
+    qCDebug(POLKITQT1_CORE) << "polkitd owner changed from" << oldOwner << "to" << newOwner;
+    if (newOwner.isEmpty()) {
+        // Decisions must not outlive the polkitd that made them
+        m_polkitLost = true;
+        q->clearCache();
+        return;
+    }
+
+    // Skip the first activation of polkitd, nothing was connected to it before
+    if (m_polkitLost || !oldOwner.isEmpty()) {
+        m_polkitLost = false;
+        reconnect();
+    }
+}
+
+void Authority::Private::seatSignalsConnect(const QString &seat)
+{
+    QString consoleKitService("org.freedesktop.ConsoleKit");
+    QString consoleKitSeatInterface("org.freedesktop.ConsoleKit.Seat");
+    // we want to connect to all slots of the seat
+    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceAdded");
+    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "DeviceRemoved");
+    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionAdded");
+    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "SessionRemoved");
+    dbusSignalAdd(consoleKitService, seat, consoleKitSeatInterface, "ActiveSessionChanged");
+}
+
+void Authority::Private::dbusSignalAdd(const QString &service, const QString &path, const QString &interface, const QString &name)
+{
+    // FIXME: This code seems to be nonfunctional - it needs to be fixed somewhere (is it Qt BUG?)
+    m_systemBus->connect(service, path, interface, name, q, SLOT(dbusFilter(QDBusMessage)));
+}
+
+void Authority::Private::dbusFilter(const QDBusMessage &message)
+{
+    if (message.type() == QDBusMessage::SignalMessage) {
+#if USE_QTDBUS_BACKEND
+        if (DBusAuthority::isChangedSignal(message)) {
+            pk_config_changed();
+            return;
+        }
+#endif
+        notifyChange(ConsoleKitDBChange);
+
+        // TODO: Test this with the multiseat support
+        if (message.member() == "SeatAdded") {
+            seatSignalsConnect(message.arguments()[0].value<QDBusObjectPath>().path());
+        }
+    }
+}
+
+/**
+ * Returns the logind id of the object at \p path, whose last element is the
+ * id escaped with "_xx" hex sequences.
+ */
+static QString loginIdFromPath(const QString &path)
+{
+    const QString escaped = path.mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+    QByteArray id;
+    for (int i = 0; i < escaped.size(); ++i) {
+        if (escaped.at(i) == QLatin1Char('_') && i + 2 < escaped.size()) {
+            bool ok = false;
+            const int c = escaped.mid(i + 1, 2).toInt(&ok, 16);
+            if (ok) {
+                id += char(c);
+                i += 2;
+                continue;
+            }
+        }
+        id += escaped.at(i).toLatin1();
+    }
+    return QString::fromUtf8(id);
+}
+
+void Authority::Private::loginFilter(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    Authority::LoginChange change;
+
+    if (message.member() == QLatin1String("PropertiesChanged")) {
+        const QString interface = arguments.value(0).toString();
+        if (interface == QLatin1String("org.freedesktop.login1.Session")) {
+            change.kind = Authority::LoginChange::SessionChanged;
+        } else if (interface == QLatin1String("org.freedesktop.login1.Seat")) {
+            change.kind = Authority::LoginChange::SeatChanged;
+        } else {
+            return;
+        }
+        change.objectPath = message.path();
+        change.id = loginIdFromPath(change.objectPath);
+        change.changedProperties = qdbus_cast<QVariantMap>(arguments.value(1)).keys();
+        change.changedProperties += arguments.value(2).toStringList();
+    } else {
+        const QString member = message.member();
+        if (member == QLatin1String("SessionNew")) {
+            change.kind = Authority::LoginChange::SessionAdded;
+        } else if (member == QLatin1String("SessionRemoved")) {
+            change.kind = Authority::LoginChange::SessionRemoved;
+        } else if (member == QLatin1String("SeatNew")) {
+            change.kind = Authority::LoginChange::SeatAdded;
+        } else if (member == QLatin1String("SeatRemoved")) {
+            change.kind = Authority::LoginChange::SeatRemoved;
+        } else {
+            return;
+        }
+        change.id = arguments.value(0).toString();
+        change.objectPath = arguments.value(1).value<QDBusObjectPath>().path();
+    }
+
+    Q_EMIT q->loginChanged(change);
+
+    // Only these property changes can change what polkitd answers
+    static const QStringList relevantProperties = QStringList()
+            << QStringLiteral("Active") << QStringLiteral("State") << QStringLiteral("ActiveSession");
+    bool relevant = change.kind != Authority::LoginChange::SessionChanged
+                    && change.kind != Authority::LoginChange::SeatChanged;
+    Q_FOREACH (const QString &property, change.changedProperties) {
+        relevant = relevant || relevantProperties.contains(property);
+    }
+    if (relevant) {
+        notifyChange(ConsoleKitDBChange);
+    }
+}
+
+bool Authority::isReady() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_ready;
+}
+
+int Authority::reconnectCount() const
+{
+    return d->m_reconnects.loadAcquire();
+}
+
+bool Authority::hasError() const
+{
+    return d->errorState().hasError;
+}
+
+Authority::ErrorCode Authority::lastError() const
+{
+    return d->errorState().lastError;
+}
+
+const QString Authority::errorDetails() const
+{
+    const Private::ErrorState &state = d->errorState();
+    if (state.lastError == E_None) {
+        return QString();
+    } else {
+        return state.details;
+    }
+}
+
+void Authority::clearError()
+{
+    Private::ErrorState &state = d->errorState();
+    state.hasError = false;
+    state.lastError = E_None;
+}
+
+PolkitDetails* convertDetailsMap(const DetailsMap &details)
+{
+    if (details.empty())
+        return nullptr;
+
+    auto ret = polkit_details_new();
+
+    for (const auto &entry: details.toStdMap()) {
+        const auto &key = entry.first;
+        const auto &value = entry.second;
+
+        polkit_details_insert(ret, key.toUtf8().constData(), value.toUtf8().data());
+    }
+
+    return ret;
+}
+
+#if !USE_QTDBUS_BACKEND
+/**
+ * Holds a reference of \p details for calls started through startCall(). It
+ * is dropped with the last copy of the guard, also when the call never starts
+ * because there is no authority.
+ */
+static QSharedPointer<PolkitDetails> detailsGuard(PolkitDetails *details)
+{
+    return QSharedPointer<PolkitDetails>(details, [](PolkitDetails *details) {
+        if (details) {
+            g_object_unref(details);
+        }
+    });
+}
+#endif
+
+PolkitDetails *Authority::Private::polkitDetails(const DetailsMap &details, PolkitDetails *prepared)
+{
+    if (prepared) {
+        return static_cast<PolkitDetails *>(g_object_ref(prepared));
+    }
+    return convertDetailsMap(details);
+}
+
+void Authority::Private::pk_config_changed()
+{
+    Authority *authority = Authority::instance();
+    authority->d->notifyChange(ConfigChange);
+}
+
+QString Authority::Private::cacheKey(const QString &actionId, const Subject &subject,
+                                     Authority::AuthorizationFlags flags, const DetailsMap &details) const
 {
-    if (d->m_lastError == E_None) {
+    // Interactive checks may end with a one-shot authorization, never reuse them
+    if ((flags & Authority::AllowUserInteraction)) {
         return QString();
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cacheMode == Authority::CacheDisabled) {
+            return QString();
+        }
+    }
+
+    // Every field is length prefixed so that no two different checks share a key
+    QString key;
+    const auto appendField = [&key](const QString &field) {
+        key += QString::number(field.size());
+        key += QLatin1Char(':');
+        key += field;
+    };
+
+    appendField(actionId);
+    appendField(subject.toString());
+    appendField(QString::number(int(flags)));
+    for (auto it = details.constBegin(); it != details.constEnd(); ++it) {
+        appendField(it.key());
+        appendField(it.value());
+    }
+
+    return key;
+}
+
+bool Authority::Private::cacheLookup(const QString &key, Authority::Result *result)
+{
+    if (key.isEmpty()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_decisionCache.constFind(key);
+    if (it == m_decisionCache.constEnd()) {
+        ++m_cacheMisses;
+        return false;
+    }
+
+    ++m_cacheHits;
+    *result = it.value();
+    return true;
+}
+
+void Authority::Private::cacheInsert(const QString &key, const Authority::CheckResult &res)
+{
+    // A temporary authorization expires without polkitd telling anybody
+    if (key.isEmpty() || res.isError() || !res.temporaryAuthorizationId.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_cacheMode == Authority::CacheDisabled) {
+        return;
+    }
+
+    if (res.result == Authority::Yes || res.result == Authority::No
+            || (res.result == Authority::Challenge && m_cacheMode == Authority::CacheDecisionsAndChallenges)) {
+        m_decisionCache.insert(key, res.result);
+    }
+}
+
+void Authority::setCacheMode(CacheMode mode)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_cacheMode = mode;
+    d->m_decisionCache.clear();
+}
+
+Authority::CacheMode Authority::cacheMode() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheMode;
+}
+
+void Authority::Private::notifyChange(Change change)
+{
+    Tracer::instantEvent("authority", change == ConfigChange ? "configChange" : "consoleKitDBChange");
+    q->clearCache();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_changeGeneration;
+    }
+    if (change == ConfigChange) {
+        m_pendingConfigChanged = true;
+    } else {
+        m_pendingConsoleKitDBChanged = true;
+    }
+
+    if (m_coalescingInterval <= 0) {
+        flushChanges();
+        return;
+    }
+
+    if (m_coalescingTimer == nullptr) {
+        m_coalescingTimer = new QTimer(q);
+        m_coalescingTimer->setSingleShot(true);
+        QObject::connect(m_coalescingTimer, &QTimer::timeout, q, [this]() {
+            flushChanges();
+        });
+    }
+    if (!m_coalescingTimer->isActive()) {
+        m_burstTimer.start();
+    } else if (m_burstTimer.elapsed() >= 10 * m_coalescingInterval) {
+        // Don't let an endless burst hold back every notification
+        flushChanges();
+        return;
+    }
+    m_coalescingTimer->start(m_coalescingInterval);
+}
+
+void Authority::Private::flushChanges()
+{
+    if (m_coalescingTimer != nullptr) {
+        m_coalescingTimer->stop();
+    }
+
+    const bool configChanged = m_pendingConfigChanged;
+    const bool consoleKitDBChanged = m_pendingConsoleKitDBChanged;
+    m_pendingConfigChanged = false;
+    m_pendingConsoleKitDBChanged = false;
+
+    if (configChanged) {
+        Q_EMIT q->configChanged();
+    }
+    if (consoleKitDBChanged) {
+        Q_EMIT q->consoleKitDBChanged();
+    }
+    if (configChanged || consoleKitDBChanged) {
+        const quint64 generation = q->changeGeneration();
+        qCDebug(POLKITQT1_CORE, "changes reported config=%d consolekit=%d generation=%llu",
+                configChanged, consoleKitDBChanged, generation);
+        Tracer::instantEvent("authority", "authorizationsChanged");
+        Q_EMIT q->authorizationsChanged(generation);
+    }
+}
+
+void Authority::setChangeCoalescingInterval(int msec)
+{
+    d->m_coalescingInterval = msec;
+    if (msec <= 0) {
+        d->flushChanges();
+    }
+}
+
+int Authority::changeCoalescingInterval() const
+{
+    return d->m_coalescingInterval;
+}
+
+quint64 Authority::changeGeneration() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_changeGeneration;
+}
+
+void Authority::setStatisticsEnabled(bool enabled)
+{
+    d->m_statistics.setEnabled(enabled);
+}
+
+bool Authority::isStatisticsEnabled() const
+{
+    return d->m_statistics.isEnabled();
+}
+
+Authority::OperationStatistics Authority::statistics(Operation operation) const
+{
+    return d->m_statistics.statistics(operation);
+}
+
+void Authority::resetStatistics()
+{
+    d->m_statistics.reset();
+}
+
+void Authority::clearCache()
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_decisionCache.clear();
+}
+
+quint64 Authority::cacheHits() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheHits;
+}
+
+quint64 Authority::cacheMisses() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_cacheMisses;
+}
+
+void Authority::setWorkerThreadEnabled(bool enabled)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_useWorkerThread = enabled;
+}
+
+bool Authority::isWorkerThreadEnabled() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_useWorkerThread;
+}
+
+void Authority::Private::startCall(const std::function<void(PolkitAuthority *, GAsyncReadyCallback, gpointer)> &start,
+                                   GAsyncReadyCallback callback, gpointer userData)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_ready) {
+        m_queuedCalls.append([this, start, callback, userData]() {
+            startCall(start, callback, userData);
+        });
+        return;
+    }
+    locker.unlock();
+
+    PolkitAuthority *authority = q->polkitAuthority();
+    locker.relock();
+    std::function<void(PolkitAuthority *, GAsyncReadyCallback, gpointer)> call = start;
+    if (authority == nullptr) {
+        // polkit would drop the call without calling back, leaving whoever waits for it waiting forever
+        const QByteArray message = m_authorityError.isEmpty() ? QByteArrayLiteral("Cannot get the authority")
+                                                              : m_authorityError.toUtf8();
+        call = [message](PolkitAuthority *, GAsyncReadyCallback callback, gpointer userData) {
+            GTask *task = g_task_new(nullptr, nullptr, callback, userData);
+            g_task_return_new_error(task, missingAuthorityDomain(), 0, "%s", message.constData());
+            g_object_unref(task);
+        };
+    }
+    if (!m_useWorkerThread) {
+        locker.unlock();
+        call(authority, callback, userData);
+        return;
+    }
+
+    if (m_workerThread == nullptr) {
+        m_replyRelay = new ReplyRelay;
+        m_replyRelay->moveToThread(q->thread());
+        m_workerThread = new WorkerThread;
+        m_workerThread->start();
+    }
+    locker.unlock();
+
+    auto forwarded = new ForwardedCall{m_replyRelay, callback, userData};
+    m_workerThread->dispatch([call, authority, forwarded]() {
+        call(authority, forwardReply, forwarded);
+    });
+}
+
+void Authority::Private::forwardReply(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto forwarded = static_cast<ForwardedCall *>(user_data);
+    // No object for calls that could not be made
+    if (object != nullptr) {
+        g_object_ref(object);
+    }
+    g_object_ref(result);
+
+    QCoreApplication::postEvent(forwarded->relay, new ReplyRelay::ReplyEvent([forwarded, object, result]() {
+        forwarded->callback(object, result, forwarded->userData);
+        g_object_unref(result);
+        if (object != nullptr) {
+            g_object_unref(object);
+        }
+        delete forwarded;
+    }));
+}
+
+GQuark Authority::Private::missingAuthorityDomain()
+{
+    return g_quark_from_static_string("polkit-qt-1-missing-authority");
+}
+
+bool Authority::Private::authorityMissing(QString *details) const
+{
+#if USE_QTDBUS_BACKEND
+    // The checks do not need polkit-gobject, QtDBus reports why they fail
+    Q_UNUSED(details)
+    return false;
+#else
+    QMutexLocker locker(&m_mutex);
+    if (!m_ready || pkAuthority != nullptr) {
+        return false;
+    }
+    *details = m_authorityError;
+    return true;
+#endif
+}
+
+bool Authority::Private::scheduleCheck(const std::function<bool()> &start)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_maxInFlightChecks > 0 && (m_inFlightChecks >= m_maxInFlightChecks || !m_waitingChecks.isEmpty())) {
+        if (m_maxQueuedChecks > 0 && m_waitingChecks.size() >= m_maxQueuedChecks) {
+            qCDebug(POLKITQT1_CORE, "check rejected in_flight=%d queued=%d", m_inFlightChecks, m_waitingChecks.size());
+            return false;
+        }
+        m_waitingChecks.enqueue(start);
+        return true;
+    }
+
+    ++m_inFlightChecks;
+    locker.unlock();
+    if (!start()) {
+        checkFinished();
+    }
+    return true;
+}
+
+void Authority::Private::checkFinished()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        --m_inFlightChecks;
+    }
+    startWaitingChecks();
+}
+
+void Authority::Private::startWaitingChecks()
+{
+    // A loop rather than recursion, many queued checks may have been cancelled
+    for (;;) {
+        std::function<bool()> start;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_waitingChecks.isEmpty()
+                    || (m_maxInFlightChecks > 0 && m_inFlightChecks >= m_maxInFlightChecks)) {
+                return;
+            }
+            start = m_waitingChecks.dequeue();
+            ++m_inFlightChecks;
+        }
+
+        if (!start()) {
+            QMutexLocker locker(&m_mutex);
+            --m_inFlightChecks;
+        }
+    }
+}
+
+void Authority::setMaxInFlightChecks(int max)
+{
+    {
+        QMutexLocker locker(&d->m_mutex);
+        d->m_maxInFlightChecks = qMax(0, max);
+    }
+    // A higher limit frees slots for the waiting checks
+    d->startWaitingChecks();
+}
+
+int Authority::maxInFlightChecks() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_maxInFlightChecks;
+}
+
+void Authority::setMaxQueuedChecks(int max)
+{
+    QMutexLocker locker(&d->m_mutex);
+    d->m_maxQueuedChecks = qMax(0, max);
+}
+
+int Authority::maxQueuedChecks() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_maxQueuedChecks;
+}
+
+int Authority::inFlightChecks() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_inFlightChecks;
+}
+
+int Authority::queuedChecks() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_waitingChecks.size();
+}
+
+void Authority::setCallTimeout(int msec)
+{
+    d->m_callTimeout.storeRelease(qMax(0, msec));
+}
+
+int Authority::callTimeout() const
+{
+    return d->m_callTimeout.loadAcquire();
+}
+
+PolkitAuthority *Authority::polkitAuthority() const
+{
+#if USE_QTDBUS_BACKEND
+    QMutexLocker locker(&d->m_mutex);
+    if (d->pkAuthority == nullptr) {
+#ifndef POLKIT_QT_1_COMPATIBILITY_MODE
+        GError *error = nullptr;
+        d->pkAuthority = polkit_authority_get_sync(nullptr, &error);
+        if (error != nullptr) {
+            d->m_authorityError = QString::fromUtf8(error->message);
+            d->setError(E_GetAuthority, error->message);
+            g_error_free(error);
+        }
+#else
+        d->pkAuthority = polkit_authority_get();
+#endif
+    }
+#else
+    d->waitUntilReady();
+#endif
+    return d->pkAuthority;
+}
+
+Authority::CheckResult Authority::Private::checkAuthorizationSync(const QString &actionId, const Subject &subject,
+                                                                 Authority::AuthorizationFlags flags, const DetailsMap &details,
+                                                                 PolkitDetails *prepared)
+{
+    if (!subject.isValid()) {
+        return CheckResult(Unknown, E_WrongSubject);
+    }
+
+    const QString key = cacheKey(actionId, subject, flags, details);
+    Authority::Result cached;
+    if (cacheLookup(key, &cached)) {
+        return CheckResult(cached);
+    }
+
+    const Statistics::Timer timer = m_statistics.start(CheckAuthorizationOperation);
+#if USE_QTDBUS_BACKEND
+    Q_UNUSED(prepared)
+    // Lets polkitd drop the check once it timed out
+    const QString cancellationId = DBusAuthority::newCancellationId();
+    QDBusPendingCall call = dbusAuthority->checkAuthorization(actionId, subject, flags, details, cancellationId,
+                                                              dbusTimeout());
+    call.waitForFinished();
+    const CheckResult res = checkAuthorizationReply(call.reply());
+    if (res.error == E_Timeout) {
+        dbusAuthority->cancelCheckAuthorization(cancellationId);
+    }
+#else
+    GError *error = nullptr;
+    auto pk_details = polkitDetails(details, prepared);
+    const Deadline deadline(this, callTimeout(flags));
+
+    PolkitAuthorizationResult *pk_result = polkit_authority_check_authorization_sync(q->polkitAuthority(),
+                subject.subject(),
+                actionId.toLatin1().data(),
+                pk_details,
+                (PolkitCheckAuthorizationFlags)(int)flags,
+                deadline.cancellable(),
+                &error);
+
+    if (pk_details) {
+        g_object_unref(pk_details);
+    }
+
+    CheckResult res;
+    if (error != nullptr) {
+        res = CheckResult(Unknown, errorCode(deadline, E_CheckFailed), errorDetails(deadline, error));
+        g_error_free(error);
+    } else if (!pk_result) {
+        res = CheckResult(Unknown, E_UnknownResult);
     } else {
-        return d->m_errorDetails;
+        res = polkitResultToCheckResult(pk_result);
+        g_object_unref(pk_result);
     }
+#endif
+
+    timer.finish(res.isError() ? Statistics::Failed : Statistics::Succeeded);
+    cacheInsert(key, res);
+    return res;
 }
 
-void Authority::clearError()
+Authority::Result Authority::checkAuthorizationSyncWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
 {
-    d->m_hasError = false;
-    d->m_lastError = E_None;
+    if (Authority::instance()->hasError()) {
+        return Unknown;
+    }
+
+    const CheckResult res = d->checkAuthorizationSync(actionId, subject, flags, details);
+    if (res.isError()) {
+        d->setError(res.error, res.errorDetails);
+    }
+    return res.result;
 }
 
-PolkitDetails* Authority::Private::convertDetailsMap(const DetailsMap &details)
+Authority::Result Authority::checkAuthorizationSyncWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const Details &details)
 {
-    if (details.empty())
-        return nullptr;
+    if (Authority::instance()->hasError()) {
+        return Unknown;
+    }
 
-    auto ret = polkit_details_new();
+    const CheckResult res = d->checkAuthorizationSync(actionId, subject, flags, details.toMap(), details.details());
+    if (res.isError()) {
+        d->setError(res.error, res.errorDetails);
+    }
+    return res.result;
+}
 
-    for (const auto &entry: details.toStdMap()) {
-        const auto &key = entry.first;
-        const auto &value = entry.second;
+Authority::CheckResult Authority::checkAuthorizationResultSync(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+{
+    return d->checkAuthorizationSync(actionId, subject, flags, details);
+}
 
-        polkit_details_insert(ret, key.toUtf8().constData(), value.toUtf8().data());
+Authority::Result Authority::checkAuthorizationSync(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
+{
+    return checkAuthorizationSyncWithDetails(actionId, subject, flags, DetailsMap());
+}
+
+void Authority::checkAuthorizationWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+{
+    if (Authority::instance()->hasError()) {
+        return;
     }
 
-    return ret;
+    d->checkAuthorizationWithDetails(actionId, subject, flags, details, nullptr);
 }
 
-void Authority::Private::pk_config_changed()
+void Authority::checkAuthorizationWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const Details &details)
 {
-    Q_EMIT Authority::instance()->configChanged();
+    if (Authority::instance()->hasError()) {
+        return;
+    }
+
+    d->checkAuthorizationWithDetails(actionId, subject, flags, details.toMap(), details.details());
 }
 
-PolkitAuthority *Authority::polkitAuthority() const
+void Authority::Private::checkAuthorizationWithDetails(const QString &actionId, const Subject &subject,
+                                                       AuthorizationFlags flags, const DetailsMap &details,
+                                                       PolkitDetails *prepared)
 {
-    return d->pkAuthority;
+    if (!subject.isValid()) {
+        setError(E_WrongSubject);
+        return;
+    }
+
+#if USE_QTDBUS_BACKEND
+    // The details are marshalled from the map
+    Q_UNUSED(prepared)
+    const QString cancellationId = DBusAuthority::newCancellationId();
+    const Statistics::Timer timer = m_statistics.start(CheckAuthorizationOperation);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingCheckIds.append(cancellationId);
+    }
+    const bool scheduled = scheduleCheck([=]() {
+        // Cancelled by checkAuthorizationCancel() while it waited
+        if (!isPendingCheck(cancellationId)) {
+            timer.finish(Statistics::Cancelled);
+            return false;
+        }
+
+        watchReply(dbusAuthority->checkAuthorization(actionId, subject, flags, details, cancellationId),
+                   [this, cancellationId, timer](const QDBusMessage &reply) {
+            checkFinished();
+            // Checks cancelled by checkAuthorizationCancel() are no longer pending
+            if (!takePendingCheck(cancellationId)) {
+                timer.finish(Statistics::Cancelled);
+                return;
+            }
+            if (reply.type() == QDBusMessage::ErrorMessage) {
+                timer.finish(Statistics::Failed);
+                setError(E_CheckFailed, reply.errorMessage());
+                return;
+            }
+            timer.finish(Statistics::Succeeded);
+            Q_EMIT q->checkAuthorizationFinished(DBusAuthority::checkAuthorizationResult(reply));
+        });
+        return true;
+    });
+
+    if (!scheduled) {
+        takePendingCheck(cancellationId);
+        timer.finish(Statistics::Failed);
+        setError(E_Overloaded, QStringLiteral("Too many authorization checks are waiting"));
+    }
+#else
+    const QSharedPointer<PolkitDetails> pk_details = detailsGuard(polkitDetails(details, prepared));
+    GCancellable *cancellable = m_checkAuthorizationCancellable;
+    const QByteArray action = actionId.toLatin1();
+    auto call = new SignalCall{q, m_statistics.start(CheckAuthorizationOperation)};
+
+    const bool scheduled = scheduleCheck([=]() {
+        startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+            polkit_authority_check_authorization(authority,
+                                                 subject.subject(),
+                                                 action.constData(),
+                                                 pk_details.data(),
+                                                 (PolkitCheckAuthorizationFlags)(int)flags,
+                                                 cancellable,
+                                                 callback, userData);
+        }, checkAuthorizationCallback, call);
+        return true;
+    });
+
+    if (!scheduled) {
+        call->timer.finish(Statistics::Failed);
+        delete call;
+        setError(E_Overloaded, QStringLiteral("Too many authorization checks are waiting"));
+    }
+#endif
 }
 
-Authority::Result Authority::checkAuthorizationSyncWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+void Authority::checkAuthorization(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
+{
+    checkAuthorizationWithDetails(actionId, subject, flags, DetailsMap());
+}
+
+void Authority::Private::checkAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
+
+    Q_ASSERT(authority != nullptr);
+    authority->d->checkFinished();
+
+    GError *error = nullptr;
+    PolkitAuthorizationResult *pkResult = finishCall(polkit_authority_check_authorization_finish, object, result, &error);
+
+    if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
+        // We don't want to set error if this is cancellation of some action
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_CheckFailed), error->message);
+        }
+        g_error_free(error);
+        return;
+    }
+    if (pkResult != nullptr) {
+        timer.finish(Statistics::Succeeded);
+        Q_EMIT authority->checkAuthorizationFinished(polkitResultToResult(pkResult));
+        g_object_unref(pkResult);
+    } else {
+        timer.finish(Statistics::Failed);
+        authority->d->setError(E_UnknownResult);
+    }
+}
+
+void Authority::checkAuthorizationCancel()
+{
+#if USE_QTDBUS_BACKEND
+    QStringList cancellationIds;
+    {
+        QMutexLocker locker(&d->m_mutex);
+        cancellationIds.swap(d->m_pendingCheckIds);
+    }
+    Q_FOREACH (const QString &cancellationId, cancellationIds) {
+        d->dbusAuthority->cancelCheckAuthorization(cancellationId);
+    }
+#endif
+    if (!g_cancellable_is_cancelled(d->m_checkAuthorizationCancellable)) {
+        g_cancellable_cancel(d->m_checkAuthorizationCancellable);
+    }
+}
+
+void Authority::Private::startCheck(const QString &actionId, const Subject &subject, Authority::AuthorizationFlags flags,
+                                    const DetailsMap &details, const Deadline &deadline, const QString &cancellationId,
+                                    const std::function<void(const Authority::CheckResult &)> &done)
+{
+#if !USE_QTDBUS_BACKEND
+    Q_UNUSED(cancellationId)
+#endif
+    // Frees the slot of the check before its outcome is reported
+    const std::function<void(const Authority::CheckResult &)> finished = [this, done](const Authority::CheckResult &res) {
+        checkFinished();
+        done(res);
+    };
+#if USE_QTDBUS_BACKEND
+    const Deadline *bound = &deadline;
+#endif
+    GCancellable *cancellable = deadline.cancellable();
+
+    const bool scheduled = scheduleCheck([=]() {
+        // Cancelled while it waited, don't bother polkitd with it
+        if (cancellable != nullptr && g_cancellable_is_cancelled(cancellable)) {
+            done(Authority::CheckResult(Authority::Unknown, E_CheckFailed, QStringLiteral("The check was cancelled")));
+            return false;
+        }
+
+#if USE_QTDBUS_BACKEND
+        // Only the time left counts for checks that waited in the queue
+        watchReply(dbusAuthority->checkAuthorization(actionId, subject, flags, details, cancellationId,
+                                                     bound->remainingTime()),
+                   [this, finished, cancellationId](const QDBusMessage &reply) {
+            const Authority::CheckResult res = checkAuthorizationReply(reply);
+            if (res.error == E_Timeout && !cancellationId.isEmpty()) {
+                dbusAuthority->cancelCheckAuthorization(cancellationId);
+            }
+            finished(res);
+        });
+#else
+        const QSharedPointer<PolkitDetails> pk_details = detailsGuard(convertDetailsMap(details));
+        const QByteArray action = actionId.toLatin1();
+
+        startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+            polkit_authority_check_authorization(authority,
+                                                 subject.subject(),
+                                                 action.constData(),
+                                                 pk_details.data(),
+                                                 (PolkitCheckAuthorizationFlags)(int)flags,
+                                                 cancellable,
+                                                 callback, userData);
+        }, checkAuthorizationAsyncCallback, new std::function<void(const Authority::CheckResult &)>(finished));
+#endif
+        return true;
+    });
+
+    if (!scheduled) {
+        done(Authority::CheckResult(Authority::Unknown, E_Overloaded,
+                                    QStringLiteral("Too many authorization checks are waiting")));
+    }
+}
+
+void Authority::Private::checkAuthorizationAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto done = static_cast<std::function<void(const Authority::CheckResult &)> *>(user_data);
+    (*done)(checkAuthorizationFinish(object, result));
+    delete done;
+}
+
+Authority::CheckResult Authority::Private::checkAuthorizationFinish(GObject *object, GAsyncResult *result)
 {
-    PolkitAuthorizationResult *pk_result;
     GError *error = nullptr;
+    PolkitAuthorizationResult *pkResult = finishCall(polkit_authority_check_authorization_finish, object, result, &error);
+
+    if (error != nullptr) {
+        const Authority::CheckResult res(Authority::Unknown, errorCode(error, E_CheckFailed), QString::fromUtf8(error->message));
+        g_error_free(error);
+        return res;
+    }
+    if (pkResult == nullptr) {
+        return Authority::CheckResult(Authority::Unknown, E_UnknownResult);
+    }
 
+    const Authority::CheckResult res = polkitResultToCheckResult(pkResult);
+    g_object_unref(pkResult);
+    return res;
+}
+
+#if USE_QTDBUS_BACKEND
+Authority::CheckResult Authority::Private::checkAuthorizationReply(const QDBusMessage &reply)
+{
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        return Authority::CheckResult(Authority::Unknown, errorCode(reply, E_CheckFailed), reply.errorMessage());
+    }
+    Authority::CheckResult res;
+    res.result = DBusAuthority::checkAuthorizationResult(reply, &res.temporaryAuthorizationId);
+    return res;
+}
+#endif
+
+QFuture<Authority::Result> Authority::checkAuthorizationAsync(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+{
     if (Authority::instance()->hasError()) {
-        return Unknown;
+        return finishedFuture(Unknown);
     }
 
     if (!subject.isValid()) {
         d->setError(E_WrongSubject);
-        return Unknown;
+        return finishedFuture(Unknown);
     }
 
-    auto pk_details = Authority::Private::convertDetailsMap(details);
+    const QString cacheKey = d->cacheKey(actionId, subject, flags, details);
+    Result cached;
+    if (d->cacheLookup(cacheKey, &cached)) {
+        return finishedFuture(cached);
+    }
 
-    pk_result = polkit_authority_check_authorization_sync(d->pkAuthority,
-                subject.subject(),
-                actionId.toLatin1().data(),
-                pk_details,
-                (PolkitCheckAuthorizationFlags)(int)flags,
-                nullptr,
-                &error);
+    auto call = new Private::AsyncCall<Result>(d, CheckAuthorizationOperation, d->callTimeout(flags));
+    call->cacheKey = cacheKey;
+    const QFuture<Result> future = call->future();
+    QString cancellationId;
+#if USE_QTDBUS_BACKEND
+    cancellationId = call->cancellationId = DBusAuthority::newCancellationId();
+#endif
 
-    if (pk_details) {
-        g_object_unref(pk_details);
+    d->startCheck(actionId, subject, flags, details, call->deadline, cancellationId, [call](const CheckResult &res) {
+        if (res.isError()) {
+            call->fail(res.error, res.errorDetails, Unknown);
+            return;
+        }
+        call->d->cacheInsert(call->cacheKey, res);
+        call->finish(res.result);
+    });
+
+    return future;
+}
+
+QFuture<Authority::CheckResult> Authority::checkAuthorizationResultAsync(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+{
+    QString reason;
+    if (d->authorityMissing(&reason)) {
+        return finishedFuture(CheckResult(Unknown, E_GetAuthority, reason));
+    }
+
+    if (!subject.isValid()) {
+        return finishedFuture(CheckResult(Unknown, E_WrongSubject));
+    }
+
+    const QString cacheKey = d->cacheKey(actionId, subject, flags, details);
+    Result cached;
+    if (d->cacheLookup(cacheKey, &cached)) {
+        return finishedFuture(CheckResult(cached));
+    }
+
+    auto call = new Private::AsyncCall<CheckResult>(d, CheckAuthorizationOperation, d->callTimeout(flags));
+    call->cacheKey = cacheKey;
+    const QFuture<CheckResult> future = call->future();
+    QString cancellationId;
+#if USE_QTDBUS_BACKEND
+    cancellationId = call->cancellationId = DBusAuthority::newCancellationId();
+#endif
+
+    d->startCheck(actionId, subject, flags, details, call->deadline, cancellationId, [call](const CheckResult &res) {
+        call->d->cacheInsert(call->cacheKey, res);
+        call->failed = res.isError();
+        call->finish(res);
+    });
+
+    return future;
+}
+
+void Authority::Private::startBatch(BatchCall *batch, const QList<Authority::CheckRequest> &requests,
+                                    Authority::AuthorizationFlags flags, const Deadline &deadline)
+{
+    batch->deadline = &deadline;
+    for (int i = 0; i < requests.size(); ++i) {
+        const Authority::CheckRequest &request = requests.at(i);
+        if (!request.subject.isValid()) {
+            batch->results[i] = Authority::CheckResult(Authority::Unknown, E_WrongSubject);
+            continue;
+        }
+
+        batch->cacheKeys[i] = cacheKey(request.actionId, request.subject, flags, request.details);
+        Authority::Result cached;
+        if (cacheLookup(batch->cacheKeys.at(i), &cached)) {
+            batch->results[i] = Authority::CheckResult(cached);
+            continue;
+        }
+
+        ++batch->pending;
+        if (batch->call) {
+            startCheck(request.actionId, request.subject, flags, request.details, deadline, QString(),
+                       [this, batch, i](const Authority::CheckResult &res) {
+                batchCheckFinished(batch, i, res);
+            });
+            continue;
+        }
+
+        // Synchronous batches collect their replies themselves
+#if USE_QTDBUS_BACKEND
+        batch->dbusCalls.append(qMakePair(i, QDBusPendingCall(dbusAuthority->checkAuthorization(request.actionId, request.subject,
+                                                                                                 flags, request.details, QString(),
+                                                                                                 deadline.remainingTime()))));
+#else
+        auto pk_details = convertDetailsMap(request.details);
+
+        polkit_authority_check_authorization(q->polkitAuthority(),
+                                             request.subject.subject(),
+                                             request.actionId.toLatin1().data(),
+                                             pk_details,
+                                             (PolkitCheckAuthorizationFlags)(int)flags,
+                                             deadline.cancellable(),
+                                             checkAuthorizationBatchCallback,
+                                             new BatchItem{batch, i});
+
+        if (pk_details) {
+            g_object_unref(pk_details);
+        }
+#endif
+    }
+}
+
+void Authority::Private::batchCheckFinished(BatchCall *batch, int index, const Authority::CheckResult &result)
+{
+    batch->results[index] = result;
+    // Checks cut short by the deadline of the batch report the timeout
+    if (result.isError() && batch->deadline->hasExpired()) {
+        batch->results[index] = timedOutValue(this, result);
+    }
+    cacheInsert(batch->cacheKeys.at(index), result);
+
+    if (--batch->pending == 0 && batch->call) {
+        batch->call->failed = batchFailed(batch->results);
+        batch->call->finish(batch->results);
+        delete batch;
+    }
+}
+
+bool Authority::Private::batchFailed(const QVector<Authority::CheckResult> &results)
+{
+    for (const Authority::CheckResult &result : results) {
+        if (result.isError()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Authority::Private::checkAuthorizationBatchCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto item = static_cast<BatchItem *>(user_data);
+    item->batch->d->batchCheckFinished(item->batch, item->index, checkAuthorizationFinish(object, result));
+    delete item;
+}
+
+QVector<Authority::CheckResult> Authority::checkAuthorizationBatchSync(const QList<CheckRequest> &requests, AuthorizationFlags flags)
+{
+    QString reason;
+    if (d->authorityMissing(&reason)) {
+        return QVector<CheckResult>(requests.size(), CheckResult(Unknown, E_GetAuthority, reason));
+    }
+
+    Private::BatchCall batch(d, requests.size());
+    const Statistics::Timer timer = d->m_statistics.start(CheckAuthorizationBatchOperation);
+    const Private::Deadline deadline(d, d->callTimeout(flags));
+
+#if USE_QTDBUS_BACKEND
+    // All checks are sent at once, so the batch takes about one round trip
+    d->startBatch(&batch, requests, flags, deadline);
+    for (int i = 0; i < batch.dbusCalls.size(); ++i) {
+        QDBusPendingCall &call = batch.dbusCalls[i].second;
+        call.waitForFinished();
+        d->batchCheckFinished(&batch, batch.dbusCalls.at(i).first, Private::checkAuthorizationReply(call.reply()));
+    }
+#else
+    // All checks are issued at once and their replies are collected on a
+    // private main context, so the batch takes about one round trip.
+    GMainContext *context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+
+    d->startBatch(&batch, requests, flags, deadline);
+    while (batch.pending > 0) {
+        g_main_context_iteration(context, TRUE);
+    }
+
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+#endif
+
+    timer.finish(Private::batchFailed(batch.results) ? Statistics::Failed : Statistics::Succeeded);
+    return batch.results;
+}
+
+QFuture<QVector<Authority::CheckResult> > Authority::checkAuthorizationBatch(const QList<CheckRequest> &requests, AuthorizationFlags flags)
+{
+    QString reason;
+    if (d->authorityMissing(&reason)) {
+        return finishedFuture(QVector<CheckResult>(requests.size(), CheckResult(Unknown, E_GetAuthority, reason)));
+    }
+
+    auto batch = new Private::BatchCall(d, requests.size());
+    batch->call = new Private::AsyncCall<QVector<CheckResult> >(d, CheckAuthorizationBatchOperation,
+                                                                 d->callTimeout(flags));
+    const QFuture<QVector<CheckResult> > future = batch->call->future();
+
+    // Checks rejected by the scheduler finish right away, so hold the batch
+    // open until all of them have been started
+    ++batch->pending;
+    d->startBatch(batch, requests, flags, batch->call->deadline);
+    if (--batch->pending == 0) {
+        batch->call->failed = Private::batchFailed(batch->results);
+        batch->call->finish(batch->results);
+        delete batch;
+    }
+
+    return future;
+}
+
+Authority::ActionsResult Authority::Private::enumerateActionsSync()
+{
+    QString reason;
+    if (authorityMissing(&reason)) {
+        return ActionsResult(ActionDescription::List(), E_GetAuthority, reason);
+    }
+
+    const Statistics::Timer timer = m_statistics.start(EnumerateActionsOperation);
+#if USE_QTDBUS_BACKEND
+    QDBusPendingCall call = dbusAuthority->enumerateActions(dbusTimeout());
+    call.waitForFinished();
+    if (call.isError()) {
+        timer.finish(Statistics::Failed);
+        return ActionsResult(ActionDescription::List(), errorCode(call.reply(), E_EnumFailed), call.error().message());
     }
 
+    timer.finish(Statistics::Succeeded);
+    return ActionsResult(DBusAuthority::actionDescriptions(call.reply()));
+#else
+    GError *error = nullptr;
+
+    const Deadline deadline(this, callTimeout());
+    GList *glist = polkit_authority_enumerate_actions_sync(q->polkitAuthority(),
+                   deadline.cancellable(),
+                   &error);
+
     if (error != nullptr) {
-        d->setError(E_CheckFailed, error->message);
+        timer.finish(Statistics::Failed);
+        const ActionsResult res(ActionDescription::List(), errorCode(deadline, E_EnumFailed), errorDetails(deadline, error));
         g_error_free(error);
-        return Unknown;
+        return res;
     }
 
-    if (!pk_result) {
-        d->setError(E_UnknownResult);
-        return Unknown;
-    } else {
-        Authority::Result res = polkitResultToResult(pk_result);
-        g_object_unref(pk_result);
-        return res;
+    timer.finish(Statistics::Succeeded);
+    return ActionsResult(actionsToListAndFree(glist));
+#endif
+}
+
+ActionDescription::List Authority::enumerateActionsSync()
+{
+    if (Authority::instance()->hasError()) {
+        return ActionDescription::List();
+    }
+
+    const ActionsResult res = d->enumerateActionsSync();
+    if (res.isError()) {
+        d->setError(res.error, res.errorDetails);
     }
+    return res.actions;
 }
 
-Authority::Result Authority::checkAuthorizationSync(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
+Authority::ActionsResult Authority::enumerateActionsResultSync()
 {
-    return checkAuthorizationSyncWithDetails(actionId, subject, flags, DetailsMap());
+    return d->enumerateActionsSync();
 }
 
-void Authority::checkAuthorizationWithDetails(const QString &actionId, const Subject &subject, AuthorizationFlags flags, const DetailsMap &details)
+void Authority::enumerateActions()
 {
     if (Authority::instance()->hasError()) {
         return;
     }
 
-    if (!subject.isValid()) {
-        d->setError(E_WrongSubject);
+#if USE_QTDBUS_BACKEND
+    const Statistics::Timer timer = d->m_statistics.start(EnumerateActionsOperation);
+    d->watchReply(d->dbusAuthority->enumerateActions(), [this, timer](const QDBusMessage &reply) {
+        // We don't want to set error if this is cancellation of some action
+        if (g_cancellable_is_cancelled(d->m_enumerateActionsCancellable)) {
+            timer.finish(Statistics::Cancelled);
+            return;
+        }
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            timer.finish(Statistics::Failed);
+            d->setError(E_EnumFailed, reply.errorMessage());
+            return;
+        }
+        timer.finish(Statistics::Succeeded);
+        Q_EMIT enumerateActionsFinished(DBusAuthority::actionDescriptions(reply));
+    });
+#else
+    GCancellable *cancellable = d->m_enumerateActionsCancellable;
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_enumerate_actions(authority,
+                                           cancellable,
+                                           callback,
+                                           userData);
+    }, d->enumerateActionsCallback, new Private::SignalCall{this, d->m_statistics.start(EnumerateActionsOperation)});
+#endif
+}
+
+void Authority::Private::enumerateActionsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
+    Q_ASSERT(authority != nullptr);
+    GError *error = nullptr;
+    GList *list = finishCall(polkit_authority_enumerate_actions_finish, object, result, &error);
+    if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
+        // We don't want to set error if this is cancellation of some action
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_EnumFailed), error->message);
+        }
+        g_error_free(error);
         return;
     }
 
-    auto pk_details = Authority::Private::convertDetailsMap(details);
+    timer.finish(Statistics::Succeeded);
+    Q_EMIT authority->enumerateActionsFinished(actionsToListAndFree(list));
+}
 
-    polkit_authority_check_authorization(d->pkAuthority,
-                                         subject.subject(),
-                                         actionId.toLatin1().data(),
-                                         pk_details,
-                                         (PolkitCheckAuthorizationFlags)(int)flags,
-                                         d->m_checkAuthorizationCancellable,
-                                         d->checkAuthorizationCallback, this);
+GCancellable *Authority::Private::startChunked()
+{
+    GCancellable *cancellable = g_cancellable_new();
+    QMutexLocker locker(&m_mutex);
+    m_chunkedCancellables.append(cancellable);
+    return cancellable;
+}
 
-    if (pk_details) {
-        g_object_unref(pk_details);
+void Authority::Private::finishChunked(GCancellable *cancellable, Authority::ErrorCode error)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_chunkedCancellables.removeOne(cancellable);
     }
+    const bool cancelled = g_cancellable_is_cancelled(cancellable);
+    g_object_unref(cancellable);
+    Q_EMIT q->enumerateActionsChunkedFinished(cancelled ? E_None : error, cancelled);
 }
 
-void Authority::checkAuthorization(const QString &actionId, const Subject &subject, AuthorizationFlags flags)
+void Authority::enumerateActionsChunked(int chunkSize)
 {
-    checkAuthorizationWithDetails(actionId, subject, flags, DetailsMap());
+    chunkSize = qMax(1, chunkSize);
+    GCancellable *cancellable = d->startChunked();
+#if USE_QTDBUS_BACKEND
+    const Statistics::Timer timer = d->m_statistics.start(EnumerateActionsOperation);
+    d->watchReply(d->dbusAuthority->enumerateActions(), [this, timer, chunkSize, cancellable](const QDBusMessage &reply) {
+        // We don't want to set error if this is cancellation of some action
+        if (g_cancellable_is_cancelled(cancellable)) {
+            timer.finish(Statistics::Cancelled);
+            d->finishChunked(cancellable, E_None);
+            return;
+        }
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            timer.finish(Statistics::Failed);
+            const ErrorCode error = Private::errorCode(reply, E_EnumFailed);
+            d->setError(error, reply.errorMessage());
+            d->finishChunked(cancellable, error);
+            return;
+        }
+        timer.finish(Statistics::Succeeded);
+
+        QSharedPointer<Private::ActionReader> reader;
+        if (reply.arguments().isEmpty()) {
+            reader = QSharedPointer<Private::ActionReader>::create([](ActionDescriptionListBuilder *) {
+                return false;
+            });
+        } else {
+            // Keeps the reply, the argument reads from it
+            const QDBusArgument argument = reply.arguments().at(0).value<QDBusArgument>();
+            argument.beginArray();
+            reader = QSharedPointer<Private::ActionReader>::create([reply, argument](ActionDescriptionListBuilder *builder) {
+                return DBusAuthority::readActionDescription(argument, builder);
+            });
+        }
+        d->emitActionChunks(reader, chunkSize, cancellable);
+    });
+#else
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_enumerate_actions(authority,
+                                           cancellable,
+                                           callback,
+                                           userData);
+    }, d->enumerateActionsChunkedCallback,
+    new Private::ChunkedCall{this, d->m_statistics.start(EnumerateActionsOperation), chunkSize, cancellable});
+#endif
 }
 
-void Authority::Private::checkAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+void Authority::Private::enumerateActionsChunkedCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
-
+    auto call = static_cast<ChunkedCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    const int chunkSize = call->chunkSize;
+    GCancellable *cancellable = call->cancellable;
+    delete call;
     Q_ASSERT(authority != nullptr);
-
     GError *error = nullptr;
-    PolkitAuthorizationResult *pkResult = polkit_authority_check_authorization_finish((PolkitAuthority *) object, result, &error);
-
+    GList *list = finishCall(polkit_authority_enumerate_actions_finish, object, result, &error);
     if (error != nullptr) {
+        const bool cancelled = g_cancellable_is_cancelled(cancellable);
+        timer.finish(cancelled ? Statistics::Cancelled : Statistics::Failed);
+        const ErrorCode code = errorCode(error, E_EnumFailed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_CheckFailed, error->message);
+        if (!cancelled) {
+            authority->d->setError(code, error->message);
         }
         g_error_free(error);
+        authority->d->finishChunked(cancellable, code);
         return;
     }
-    if (pkResult != nullptr) {
-        Q_EMIT authority->checkAuthorizationFinished(polkitResultToResult(pkResult));
-        g_object_unref(pkResult);
-    } else {
-        authority->d->setError(E_UnknownResult);
-    }
-}
 
-void Authority::checkAuthorizationCancel()
-{
-    if (!g_cancellable_is_cancelled(d->m_checkAuthorizationCancellable)) {
-        g_cancellable_cancel(d->m_checkAuthorizationCancellable);
-    }
+    timer.finish(Statistics::Succeeded);
+    // The actions not converted yet are freed with the list, also when the enumeration is cancelled
+    const QSharedPointer<GList> actions(list, [](GList *list) {
+        g_list_free_full(list, g_object_unref);
+    });
+    GList *next = list;
+    authority->d->emitActionChunks(QSharedPointer<ActionReader>::create([actions, next](ActionDescriptionListBuilder *builder) mutable {
+        if (!next) {
+            return false;
+        }
+        builder->add(static_cast<PolkitActionDescription *>(next->data));
+        next = g_list_next(next);
+        return true;
+    }), chunkSize, cancellable);
 }
 
-ActionDescription::List Authority::enumerateActionsSync()
+void Authority::Private::emitActionChunks(const QSharedPointer<ActionReader> &reader, int chunkSize, GCancellable *cancellable)
 {
-    if (Authority::instance()->hasError()) {
-        return ActionDescription::List();
+    if (g_cancellable_is_cancelled(cancellable)) {
+        finishChunked(cancellable, E_None);
+        return;
     }
 
-    GError *error = nullptr;
-
-    GList *glist = polkit_authority_enumerate_actions_sync(d->pkAuthority,
-                   nullptr,
-                   &error);
+    ActionDescriptionListBuilder builder(chunkSize);
+    int count = 0;
+    bool more = true;
+    while (count < chunkSize && (more = (*reader)(&builder))) {
+        ++count;
+    }
 
-    if (error != nullptr) {
-        d->setError(E_EnumFailed, error->message);
-        g_error_free(error);
-        return ActionDescription::List();
+    if (count > 0) {
+        Q_EMIT q->enumerateActionsChunkReady(builder.take());
+    }
+    if (!more) {
+        finishChunked(cancellable, E_None);
+        return;
     }
 
-    return actionsToListAndFree(glist);
+    QTimer::singleShot(0, q, [this, reader, chunkSize, cancellable]() {
+        emitActionChunks(reader, chunkSize, cancellable);
+    });
 }
 
-void Authority::enumerateActions()
+void Authority::enumerateActionsCancel()
 {
-    if (Authority::instance()->hasError()) {
-        return;
+    if (!g_cancellable_is_cancelled(d->m_enumerateActionsCancellable)) {
+        g_cancellable_cancel(d->m_enumerateActionsCancellable);
+    }
+
+    // Referenced, a chunked call may finish on another thread meanwhile
+    QList<GCancellable *> chunked;
+    {
+        QMutexLocker locker(&d->m_mutex);
+        chunked = d->m_chunkedCancellables;
+        Q_FOREACH (GCancellable *cancellable, chunked) {
+            g_object_ref(cancellable);
+        }
     }
+    Q_FOREACH (GCancellable *cancellable, chunked) {
+        g_cancellable_cancel(cancellable);
+        g_object_unref(cancellable);
+    }
+}
 
-    polkit_authority_enumerate_actions(d->pkAuthority,
-                                       d->m_enumerateActionsCancellable,
-                                       d->enumerateActionsCallback,
-                                       Authority::instance());
+void Authority::Private::startEnumeration(const Deadline &deadline,
+                                          const std::function<void(const Authority::ActionsResult &)> &done)
+{
+#if USE_QTDBUS_BACKEND
+    watchReply(dbusAuthority->enumerateActions(deadline.remainingTime()), [done](const QDBusMessage &reply) {
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            done(ActionsResult(ActionDescription::List(), errorCode(reply, E_EnumFailed), reply.errorMessage()));
+            return;
+        }
+        done(ActionsResult(DBusAuthority::actionDescriptions(reply)));
+    });
+#else
+    GCancellable *cancellable = deadline.cancellable();
+    startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_enumerate_actions(authority,
+                                           cancellable,
+                                           callback,
+                                           userData);
+    }, enumerateActionsAsyncCallback, new std::function<void(const ActionsResult &)>(done));
+#endif
 }
 
-void Authority::Private::enumerateActionsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+void Authority::Private::enumerateActionsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
-    Q_ASSERT(authority != nullptr);
+    auto done = static_cast<std::function<void(const Authority::ActionsResult &)> *>(user_data);
     GError *error = nullptr;
-    GList *list = polkit_authority_enumerate_actions_finish((PolkitAuthority *) object, result, &error);
+    GList *list = finishCall(polkit_authority_enumerate_actions_finish, object, result, &error);
     if (error != nullptr) {
-        // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_EnumFailed, error->message);
-        }
+        (*done)(ActionsResult(ActionDescription::List(), errorCode(error, E_EnumFailed), QString::fromUtf8(error->message)));
         g_error_free(error);
-        return;
+    } else {
+        (*done)(ActionsResult(actionsToListAndFree(list)));
     }
+    delete done;
+}
 
-    Q_EMIT authority->enumerateActionsFinished(actionsToListAndFree(list));
+QFuture<ActionDescription::List> Authority::enumerateActionsAsync()
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(ActionDescription::List());
+    }
+
+    auto call = new Private::AsyncCall<ActionDescription::List>(d, EnumerateActionsOperation, d->callTimeout());
+    const QFuture<ActionDescription::List> future = call->future();
+    d->startEnumeration(call->deadline, [call](const ActionsResult &res) {
+        if (res.isError()) {
+            call->fail(res.error, res.errorDetails, ActionDescription::List());
+            return;
+        }
+        call->finish(res.actions);
+    });
+
+    return future;
 }
 
-void Authority::enumerateActionsCancel()
+QFuture<Authority::ActionsResult> Authority::enumerateActionsResultAsync()
 {
-    if (!g_cancellable_is_cancelled(d->m_enumerateActionsCancellable)) {
-        g_cancellable_cancel(d->m_enumerateActionsCancellable);
+    QString reason;
+    if (d->authorityMissing(&reason)) {
+        return finishedFuture(ActionsResult(ActionDescription::List(), E_GetAuthority, reason));
     }
+
+    auto call = new Private::AsyncCall<ActionsResult>(d, EnumerateActionsOperation, d->callTimeout());
+    const QFuture<ActionsResult> future = call->future();
+    d->startEnumeration(call->deadline, [call](const ActionsResult &res) {
+        call->failed = res.isError();
+        call->finish(res);
+    });
+
+    return future;
 }
 
 bool Authority::registerAuthenticationAgentSync(const Subject &subject, const QString &locale, const QString &objectPath)
@@ -517,16 +2808,20 @@ bool Authority::registerAuthenticationAgentSync(const Subject &subject, const QS
         return false;
     }
 
-    result = polkit_authority_register_authentication_agent_sync(d->pkAuthority,
+    const Statistics::Timer timer = d->m_statistics.start(RegisterAuthenticationAgentOperation);
+    const Private::Deadline deadline(d, d->callTimeout());
+    result = polkit_authority_register_authentication_agent_sync(polkitAuthority(),
              subject.subject(), locale.toLatin1().data(),
-             objectPath.toLatin1().data(), nullptr, &error);
+             objectPath.toLatin1().data(), deadline.cancellable(), &error);
 
     if (error) {
-        d->setError(E_RegisterFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_RegisterFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return false;
     }
 
+    timer.finish(Statistics::Succeeded);
     return result;
 }
 
@@ -541,30 +2836,40 @@ void Authority::registerAuthenticationAgent(const Subject &subject, const QStrin
         return;
     }
 
-    polkit_authority_register_authentication_agent(d->pkAuthority,
-            subject.subject(),
-            locale.toLatin1().data(),
-            objectPath.toLatin1().data(),
-            d->m_registerAuthenticationAgentCancellable,
-            d->registerAuthenticationAgentCallback,
-            this);
+    GCancellable *cancellable = d->m_registerAuthenticationAgentCancellable;
+    const QByteArray localeName = locale.toLatin1();
+    const QByteArray path = objectPath.toLatin1();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_register_authentication_agent(authority,
+                subject.subject(),
+                localeName.constData(),
+                path.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->registerAuthenticationAgentCallback, new Private::SignalCall{this, d->m_statistics.start(RegisterAuthenticationAgentOperation)});
 }
 
 void Authority::Private::registerAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
     Q_ASSERT(authority != nullptr);
     GError *error = nullptr;
-    bool res = polkit_authority_register_authentication_agent_finish((PolkitAuthority *) object, result, &error);
+    bool res = finishCall(polkit_authority_register_authentication_agent_finish, object, result, &error);
     if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_EnumFailed , error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_EnumFailed), error->message);
         }
         g_error_free(error);
         return;
     }
 
+    timer.finish(Statistics::Succeeded);
     Q_EMIT authority->registerAuthenticationAgentFinished(res);
 }
 
@@ -575,6 +2880,50 @@ void Authority::registerAuthenticationAgentCancel()
     }
 }
 
+QFuture<bool> Authority::registerAuthenticationAgentAsync(const Subject &subject, const QString &locale, const QString &objectPath)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(false);
+    }
+
+    if (!subject.isValid()) {
+        d->setError(E_WrongSubject);
+        return finishedFuture(false);
+    }
+
+    auto call = new Private::AsyncCall<bool>(d, RegisterAuthenticationAgentOperation, d->callTimeout());
+    const QFuture<bool> future = call->future();
+
+    GCancellable *cancellable = call->cancellable;
+    const QByteArray localeName = locale.toLatin1();
+    const QByteArray path = objectPath.toLatin1();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_register_authentication_agent(authority,
+                subject.subject(),
+                localeName.constData(),
+                path.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->registerAuthenticationAgentAsyncCallback, call);
+
+    return future;
+}
+
+void Authority::Private::registerAuthenticationAgentAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<bool> *>(user_data);
+    GError *error = nullptr;
+    bool res = finishCall(polkit_authority_register_authentication_agent_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_RegisterFailed), QString::fromUtf8(error->message), false);
+        g_error_free(error);
+        return;
+    }
+
+    call->finish(res);
+}
+
 bool Authority::unregisterAuthenticationAgentSync(const Subject &subject, const QString &objectPath)
 {
     if (d->pkAuthority) {
@@ -588,18 +2937,22 @@ bool Authority::unregisterAuthenticationAgentSync(const Subject &subject, const
 
     GError *error = nullptr;
 
-    bool result = polkit_authority_unregister_authentication_agent_sync(d->pkAuthority,
+    const Statistics::Timer timer = d->m_statistics.start(UnregisterAuthenticationAgentOperation);
+    const Private::Deadline deadline(d, d->callTimeout());
+    bool result = polkit_authority_unregister_authentication_agent_sync(polkitAuthority(),
                   subject.subject(),
                   objectPath.toUtf8().data(),
-                  nullptr,
+                  deadline.cancellable(),
                   &error);
 
     if (error != nullptr) {
-        d->setError(E_UnregisterFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_UnregisterFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return false;
     }
 
+    timer.finish(Statistics::Succeeded);
     return result;
 }
 
@@ -614,29 +2967,38 @@ void Authority::unregisterAuthenticationAgent(const Subject &subject, const QStr
         return;
     }
 
-    polkit_authority_unregister_authentication_agent(d->pkAuthority,
-            subject.subject(),
-            objectPath.toUtf8().data(),
-            d->m_unregisterAuthenticationAgentCancellable,
-            d->unregisterAuthenticationAgentCallback,
-            this);
+    GCancellable *cancellable = d->m_unregisterAuthenticationAgentCancellable;
+    const QByteArray path = objectPath.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_unregister_authentication_agent(authority,
+                subject.subject(),
+                path.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->unregisterAuthenticationAgentCallback, new Private::SignalCall{this, d->m_statistics.start(UnregisterAuthenticationAgentOperation)});
 }
 
 void Authority::Private::unregisterAuthenticationAgentCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
     Q_ASSERT(authority);
     GError *error = nullptr;
-    bool res = polkit_authority_unregister_authentication_agent_finish((PolkitAuthority *) object, result, &error);
+    bool res = finishCall(polkit_authority_unregister_authentication_agent_finish, object, result, &error);
     if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_UnregisterFailed, error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_UnregisterFailed), error->message);
         }
         g_error_free(error);
         return;
     }
 
+    timer.finish(Statistics::Succeeded);
     Q_EMIT authority->unregisterAuthenticationAgentFinished(res);
 }
 
@@ -647,6 +3009,48 @@ void Authority::unregisterAuthenticationAgentCancel()
     }
 }
 
+QFuture<bool> Authority::unregisterAuthenticationAgentAsync(const Subject &subject, const QString &objectPath)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(false);
+    }
+
+    if (!subject.isValid()) {
+        d->setError(E_WrongSubject);
+        return finishedFuture(false);
+    }
+
+    auto call = new Private::AsyncCall<bool>(d, UnregisterAuthenticationAgentOperation, d->callTimeout());
+    const QFuture<bool> future = call->future();
+
+    GCancellable *cancellable = call->cancellable;
+    const QByteArray path = objectPath.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_unregister_authentication_agent(authority,
+                subject.subject(),
+                path.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->unregisterAuthenticationAgentAsyncCallback, call);
+
+    return future;
+}
+
+void Authority::Private::unregisterAuthenticationAgentAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<bool> *>(user_data);
+    GError *error = nullptr;
+    bool res = finishCall(polkit_authority_unregister_authentication_agent_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_UnregisterFailed), QString::fromUtf8(error->message), false);
+        g_error_free(error);
+        return;
+    }
+
+    call->finish(res);
+}
+
 bool Authority::authenticationAgentResponseSync(const QString &cookie, const Identity &identity)
 {
     if (Authority::instance()->hasError()) {
@@ -660,17 +3064,21 @@ bool Authority::authenticationAgentResponseSync(const QString &cookie, const Ide
 
     GError *error = nullptr;
 
-    bool result = polkit_authority_authentication_agent_response_sync(d->pkAuthority,
+    const Statistics::Timer timer = d->m_statistics.start(AuthenticationAgentResponseOperation);
+    const Private::Deadline deadline(d, d->callTimeout());
+    bool result = polkit_authority_authentication_agent_response_sync(polkitAuthority(),
                   cookie.toUtf8().data(),
                   identity.identity(),
-                  nullptr,
+                  deadline.cancellable(),
                   &error);
     if (error != nullptr) {
-        d->setError(E_AgentResponseFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_AgentResponseFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return false;
     }
 
+    timer.finish(Statistics::Succeeded);
     return result;
 }
 
@@ -685,29 +3093,38 @@ void Authority::authenticationAgentResponse(const QString &cookie, const Identit
         return;
     }
 
-    polkit_authority_authentication_agent_response(d->pkAuthority,
-            cookie.toUtf8().data(),
-            identity.identity(),
-            d->m_authenticationAgentResponseCancellable,
-            d->authenticationAgentResponseCallback,
-            this);
+    GCancellable *cancellable = d->m_authenticationAgentResponseCancellable;
+    const QByteArray cookieData = cookie.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_authentication_agent_response(authority,
+                cookieData.constData(),
+                identity.identity(),
+                cancellable,
+                callback,
+                userData);
+    }, d->authenticationAgentResponseCallback, new Private::SignalCall{this, d->m_statistics.start(AuthenticationAgentResponseOperation)});
 }
 
 void Authority::Private::authenticationAgentResponseCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
     Q_ASSERT(authority);
     GError *error = nullptr;
-    bool res = polkit_authority_authentication_agent_response_finish((PolkitAuthority *) object, result, &error);
+    bool res = finishCall(polkit_authority_authentication_agent_response_finish, object, result, &error);
     if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_AgentResponseFailed, error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_AgentResponseFailed), error->message);
         }
         g_error_free(error);
         return;
     }
 
+    timer.finish(Statistics::Succeeded);
     Q_EMIT authority->authenticationAgentResponseFinished(res);
 }
 
@@ -718,20 +3135,78 @@ void Authority::authenticationAgentResponseCancel()
     }
 }
 
+QFuture<bool> Authority::authenticationAgentResponseAsync(const QString &cookie, const Identity &identity)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(false);
+    }
+
+    if (cookie.isEmpty() || !identity.isValid()) {
+        d->setError(E_CookieOrIdentityEmpty);
+        return finishedFuture(false);
+    }
+
+    auto call = new Private::AsyncCall<bool>(d, AuthenticationAgentResponseOperation, d->callTimeout());
+    const QFuture<bool> future = call->future();
+
+    GCancellable *cancellable = call->cancellable;
+    const QByteArray cookieData = cookie.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_authentication_agent_response(authority,
+                cookieData.constData(),
+                identity.identity(),
+                cancellable,
+                callback,
+                userData);
+    }, d->authenticationAgentResponseAsyncCallback, call);
+
+    return future;
+}
+
+void Authority::Private::authenticationAgentResponseAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<bool> *>(user_data);
+    GError *error = nullptr;
+    bool res = finishCall(polkit_authority_authentication_agent_response_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_AgentResponseFailed), QString::fromUtf8(error->message), false);
+        g_error_free(error);
+        return;
+    }
+
+    call->finish(res);
+}
+
 TemporaryAuthorization::List Authority::enumerateTemporaryAuthorizationsSync(const Subject &subject)
 {
     TemporaryAuthorization::List result;
 
+    const Statistics::Timer timer = d->m_statistics.start(EnumerateTemporaryAuthorizationsOperation);
+#if USE_QTDBUS_BACKEND
+    QDBusPendingCall call = d->dbusAuthority->enumerateTemporaryAuthorizations(subject, d->dbusTimeout());
+    call.waitForFinished();
+    if (call.isError()) {
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(call.reply(), E_EnumFailed), call.error().message());
+        return result;
+    }
+
+    timer.finish(Statistics::Succeeded);
+    return DBusAuthority::temporaryAuthorizations(call.reply());
+#else
     GError *error = nullptr;
-    GList *glist = polkit_authority_enumerate_temporary_authorizations_sync(d->pkAuthority,
+    const Private::Deadline deadline(d, d->callTimeout());
+    GList *glist = polkit_authority_enumerate_temporary_authorizations_sync(polkitAuthority(),
                    subject.subject(),
-                   nullptr,
+                   deadline.cancellable(),
                    &error);
     if (error != nullptr) {
-        d->setError(E_EnumFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_EnumFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return result;
     }
+    timer.finish(Statistics::Succeeded);
 
     GList *glist2;
     for (glist2 = glist; glist2 != nullptr; glist2 = g_list_next(glist2)) {
@@ -741,6 +3216,7 @@ TemporaryAuthorization::List Authority::enumerateTemporaryAuthorizationsSync(con
     g_list_free(glist);
 
     return result;
+#endif
 }
 
 void Authority::Private::enumerateTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
@@ -749,12 +3225,12 @@ void Authority::Private::enumerateTemporaryAuthorizationsCallback(GObject *objec
     Q_ASSERT(authority);
     GError *error = nullptr;
 
-    GList *glist = polkit_authority_enumerate_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
+    GList *glist = finishCall(polkit_authority_enumerate_temporary_authorizations_finish, object, result, &error);
 
     if (error != nullptr) {
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_EnumFailed, error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_EnumFailed), error->message);
         }
         g_error_free(error);
         return;
@@ -777,24 +3253,88 @@ void Authority::enumerateTemporaryAuthorizationsCancel()
     }
 }
 
+QFuture<TemporaryAuthorization::List> Authority::enumerateTemporaryAuthorizationsAsync(const Subject &subject)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(TemporaryAuthorization::List());
+    }
+
+    auto call = new Private::AsyncCall<TemporaryAuthorization::List>(d, EnumerateTemporaryAuthorizationsOperation,
+                                                                  d->callTimeout());
+    const QFuture<TemporaryAuthorization::List> future = call->future();
+
+#if USE_QTDBUS_BACKEND
+    d->watchReply(d->dbusAuthority->enumerateTemporaryAuthorizations(subject, call->deadline.remainingTime()), [call](const QDBusMessage &reply) {
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            call->fail(Private::errorCode(reply, E_EnumFailed), reply.errorMessage(), TemporaryAuthorization::List());
+            return;
+        }
+        call->finish(DBusAuthority::temporaryAuthorizations(reply));
+    });
+#else
+    GCancellable *cancellable = call->cancellable;
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_enumerate_temporary_authorizations(authority,
+                subject.subject(),
+                cancellable,
+                callback,
+                userData);
+    }, d->enumerateTemporaryAuthorizationsAsyncCallback, call);
+#endif
+
+    return future;
+}
+
+void Authority::Private::enumerateTemporaryAuthorizationsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<TemporaryAuthorization::List> *>(user_data);
+    GError *error = nullptr;
+    GList *glist = finishCall(polkit_authority_enumerate_temporary_authorizations_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_EnumFailed), QString::fromUtf8(error->message), TemporaryAuthorization::List());
+        g_error_free(error);
+        return;
+    }
+
+    call->finish(temporaryAuthorizationsToListAndFree(glist));
+}
+
 bool Authority::revokeTemporaryAuthorizationsSync(const Subject &subject)
 {
-    bool result;
     if (Authority::instance()->hasError()) {
         return false;
     }
 
+    const Statistics::Timer timer = d->m_statistics.start(RevokeTemporaryAuthorizationsOperation);
+#if USE_QTDBUS_BACKEND
+    QDBusPendingCall call = d->dbusAuthority->revokeTemporaryAuthorizations(subject, d->dbusTimeout());
+    call.waitForFinished();
+    if (call.isError()) {
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(call.reply(), E_RevokeFailed), call.error().message());
+        return false;
+    }
+    timer.finish(Statistics::Succeeded);
+    // Cached results may stem from the revoked authorizations
+    clearCache();
+    return true;
+#else
     GError *error = nullptr;
-    result = polkit_authority_revoke_temporary_authorizations_sync(d->pkAuthority,
+    const Private::Deadline deadline(d, d->callTimeout());
+    bool result = polkit_authority_revoke_temporary_authorizations_sync(polkitAuthority(),
              subject.subject(),
-             nullptr,
+             deadline.cancellable(),
              &error);
     if (error != nullptr) {
-        d->setError(E_RevokeFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_RevokeFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return false;
     }
+    timer.finish(Statistics::Succeeded);
+    clearCache();
     return result;
+#endif
 }
 
 void Authority::revokeTemporaryAuthorizations(const Subject &subject)
@@ -803,30 +3343,58 @@ void Authority::revokeTemporaryAuthorizations(const Subject &subject)
         return;
     }
 
-    polkit_authority_revoke_temporary_authorizations(d->pkAuthority,
-            subject.subject(),
-            d->m_revokeTemporaryAuthorizationsCancellable,
-            d->revokeTemporaryAuthorizationsCallback,
-            this);
+#if USE_QTDBUS_BACKEND
+    const Statistics::Timer timer = d->m_statistics.start(RevokeTemporaryAuthorizationsOperation);
+    d->watchReply(d->dbusAuthority->revokeTemporaryAuthorizations(subject), [this, timer](const QDBusMessage &reply) {
+        // We don't want to set error if this is cancellation of some action
+        if (g_cancellable_is_cancelled(d->m_revokeTemporaryAuthorizationsCancellable)) {
+            timer.finish(Statistics::Cancelled);
+            return;
+        }
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            timer.finish(Statistics::Failed);
+            d->setError(E_RevokeFailed, reply.errorMessage());
+            return;
+        }
+        timer.finish(Statistics::Succeeded);
+        clearCache();
+        Q_EMIT revokeTemporaryAuthorizationsFinished(true);
+    });
+#else
+    GCancellable *cancellable = d->m_revokeTemporaryAuthorizationsCancellable;
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_revoke_temporary_authorizations(authority,
+                subject.subject(),
+                cancellable,
+                callback,
+                userData);
+    }, d->revokeTemporaryAuthorizationsCallback, new Private::SignalCall{this, d->m_statistics.start(RevokeTemporaryAuthorizationsOperation)});
+#endif
 }
 
 void Authority::Private::revokeTemporaryAuthorizationsCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
     Q_ASSERT(authority != nullptr);
     GError *error = nullptr;
 
-    bool res = polkit_authority_revoke_temporary_authorizations_finish((PolkitAuthority *) object, result, &error);
+    bool res = finishCall(polkit_authority_revoke_temporary_authorizations_finish, object, result, &error);
 
     if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_RevokeFailed, error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_RevokeFailed), error->message);
         }
         g_error_free(error);
         return;
     }
 
+    timer.finish(Statistics::Succeeded);
+    authority->clearCache();
     Q_EMIT authority->revokeTemporaryAuthorizationsFinished(res);
 }
 
@@ -837,24 +3405,89 @@ void Authority::revokeTemporaryAuthorizationsCancel()
     }
 }
 
+QFuture<bool> Authority::revokeTemporaryAuthorizationsAsync(const Subject &subject)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(false);
+    }
+
+    auto call = new Private::AsyncCall<bool>(d, RevokeTemporaryAuthorizationsOperation, d->callTimeout());
+    const QFuture<bool> future = call->future();
+
+#if USE_QTDBUS_BACKEND
+    d->watchReply(d->dbusAuthority->revokeTemporaryAuthorizations(subject, call->deadline.remainingTime()), [call](const QDBusMessage &reply) {
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            call->fail(Private::errorCode(reply, E_RevokeFailed), reply.errorMessage(), false);
+            return;
+        }
+        call->d->q->clearCache();
+        call->finish(true);
+    });
+#else
+    GCancellable *cancellable = call->cancellable;
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_revoke_temporary_authorizations(authority,
+                subject.subject(),
+                cancellable,
+                callback,
+                userData);
+    }, d->revokeTemporaryAuthorizationsAsyncCallback, call);
+#endif
+
+    return future;
+}
+
+void Authority::Private::revokeTemporaryAuthorizationsAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<bool> *>(user_data);
+    GError *error = nullptr;
+    bool res = finishCall(polkit_authority_revoke_temporary_authorizations_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_RevokeFailed), QString::fromUtf8(error->message), false);
+        g_error_free(error);
+        return;
+    }
+
+    call->d->q->clearCache();
+    call->finish(res);
+}
+
 bool Authority::revokeTemporaryAuthorizationSync(const QString &id)
 {
-    bool result;
     if (Authority::instance()->hasError()) {
         return false;
     }
 
+    const Statistics::Timer timer = d->m_statistics.start(RevokeTemporaryAuthorizationOperation);
+#if USE_QTDBUS_BACKEND
+    QDBusPendingCall call = d->dbusAuthority->revokeTemporaryAuthorizationById(id, d->dbusTimeout());
+    call.waitForFinished();
+    if (call.isError()) {
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(call.reply(), E_RevokeFailed), call.error().message());
+        return false;
+    }
+    timer.finish(Statistics::Succeeded);
+    // Cached results may stem from the revoked authorizations
+    clearCache();
+    return true;
+#else
     GError *error = nullptr;
-    result =  polkit_authority_revoke_temporary_authorization_by_id_sync(d->pkAuthority,
+    const Private::Deadline deadline(d, d->callTimeout());
+    bool result =  polkit_authority_revoke_temporary_authorization_by_id_sync(polkitAuthority(),
               id.toUtf8().data(),
-              nullptr,
+              deadline.cancellable(),
               &error);
     if (error != nullptr) {
-        d->setError(E_RevokeFailed, error->message);
+        timer.finish(Statistics::Failed);
+        d->setError(Private::errorCode(deadline, E_RevokeFailed), Private::errorDetails(deadline, error));
         g_error_free(error);
         return false;
     }
+    timer.finish(Statistics::Succeeded);
+    clearCache();
     return result;
+#endif
 }
 
 void Authority::revokeTemporaryAuthorization(const QString &id)
@@ -863,30 +3496,59 @@ void Authority::revokeTemporaryAuthorization(const QString &id)
         return;
     }
 
-    polkit_authority_revoke_temporary_authorization_by_id(d->pkAuthority,
-            id.toUtf8().data(),
-            d->m_revokeTemporaryAuthorizationCancellable,
-            d->revokeTemporaryAuthorizationCallback,
-            this);
+#if USE_QTDBUS_BACKEND
+    const Statistics::Timer timer = d->m_statistics.start(RevokeTemporaryAuthorizationOperation);
+    d->watchReply(d->dbusAuthority->revokeTemporaryAuthorizationById(id), [this, timer](const QDBusMessage &reply) {
+        // We don't want to set error if this is cancellation of some action
+        if (g_cancellable_is_cancelled(d->m_revokeTemporaryAuthorizationCancellable)) {
+            timer.finish(Statistics::Cancelled);
+            return;
+        }
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            timer.finish(Statistics::Failed);
+            d->setError(E_RevokeFailed, reply.errorMessage());
+            return;
+        }
+        timer.finish(Statistics::Succeeded);
+        clearCache();
+        Q_EMIT revokeTemporaryAuthorizationFinished(true);
+    });
+#else
+    GCancellable *cancellable = d->m_revokeTemporaryAuthorizationCancellable;
+    const QByteArray idData = id.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_revoke_temporary_authorization_by_id(authority,
+                idData.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->revokeTemporaryAuthorizationCallback, new Private::SignalCall{this, d->m_statistics.start(RevokeTemporaryAuthorizationOperation)});
+#endif
 }
 
 void Authority::Private::revokeTemporaryAuthorizationCallback(GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    Authority *authority = (Authority *) user_data;
+    auto call = static_cast<SignalCall *>(user_data);
+    Authority *authority = call->authority;
+    const Statistics::Timer timer = call->timer;
+    delete call;
     Q_ASSERT(authority != nullptr);
     GError *error = nullptr;
 
-    bool res = polkit_authority_revoke_temporary_authorization_by_id_finish((PolkitAuthority *) object, result, &error);
+    bool res = finishCall(polkit_authority_revoke_temporary_authorization_by_id_finish, object, result, &error);
 
     if (error != nullptr) {
+        timer.finish(isCancelled(error) ? Statistics::Cancelled : Statistics::Failed);
         // We don't want to set error if this is cancellation of some action
-        if (error->code != 1) {
-            authority->d->setError(E_RevokeFailed, error->message);
+        if (!isCancelled(error)) {
+            authority->d->setError(errorCode(error, E_RevokeFailed), error->message);
         }
         g_error_free(error);
         return;
     }
 
+    timer.finish(Statistics::Succeeded);
+    authority->clearCache();
     Q_EMIT authority->revokeTemporaryAuthorizationFinished(res);
 }
 
@@ -897,6 +3559,54 @@ void Authority::revokeTemporaryAuthorizationCancel()
     }
 }
 
+QFuture<bool> Authority::revokeTemporaryAuthorizationAsync(const QString &id)
+{
+    if (Authority::instance()->hasError()) {
+        return finishedFuture(false);
+    }
+
+    auto call = new Private::AsyncCall<bool>(d, RevokeTemporaryAuthorizationOperation, d->callTimeout());
+    const QFuture<bool> future = call->future();
+
+#if USE_QTDBUS_BACKEND
+    d->watchReply(d->dbusAuthority->revokeTemporaryAuthorizationById(id, call->deadline.remainingTime()), [call](const QDBusMessage &reply) {
+        if (reply.type() == QDBusMessage::ErrorMessage) {
+            call->fail(Private::errorCode(reply, E_RevokeFailed), reply.errorMessage(), false);
+            return;
+        }
+        call->d->q->clearCache();
+        call->finish(true);
+    });
+#else
+    GCancellable *cancellable = call->cancellable;
+    const QByteArray idData = id.toUtf8();
+    d->startCall([=](PolkitAuthority *authority, GAsyncReadyCallback callback, gpointer userData) {
+        polkit_authority_revoke_temporary_authorization_by_id(authority,
+                idData.constData(),
+                cancellable,
+                callback,
+                userData);
+    }, d->revokeTemporaryAuthorizationAsyncCallback, call);
+#endif
+
+    return future;
+}
+
+void Authority::Private::revokeTemporaryAuthorizationAsyncCallback(GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    auto call = static_cast<AsyncCall<bool> *>(user_data);
+    GError *error = nullptr;
+    bool res = finishCall(polkit_authority_revoke_temporary_authorization_by_id_finish, object, result, &error);
+    if (error != nullptr) {
+        call->fail(errorCode(error, E_RevokeFailed), QString::fromUtf8(error->message), false);
+        g_error_free(error);
+        return;
+    }
+
+    call->d->q->clearCache();
+    call->finish(res);
+}
+
 }
 
 #include "moc_polkitqt1-authority.cpp"
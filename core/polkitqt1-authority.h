@@ -12,14 +12,17 @@
 #define POLKITQT1_AUTHORITY_H
 
 #include "polkitqt1-core-export.h"
+#include "polkitqt1-details.h"
 #include "polkitqt1-identity.h"
 #include "polkitqt1-subject.h"
 #include "polkitqt1-temporaryauthorization.h"
 #include "polkitqt1-actiondescription.h"
 
+#include <QFuture>
 #include <QObject>
 #include <QMetaType>
 #include <QStringList>
+#include <QVector>
 
 typedef struct _PolkitAuthority PolkitAuthority;
 
@@ -51,6 +54,17 @@ typedef QMap<QString, QString> DetailsMap;
  * \note This class is a singleton, its constructor is private.
  * Call Authority::instance() to get an instance of the Authority object.
  * Do not delete Authority::instance(), cleanup will be done automatically.
+ *
+ * The synchronous methods, the error state and the decision cache may be
+ * used from any thread. The error state is kept per thread, so an error hit
+ * by one thread does not block the calls of the others. Results of the
+ * asynchronous methods are delivered in the thread the authority lives in,
+ * and signals reach their receivers through the usual queued connections.
+ *
+ * polkitd is reached on the system bus. Setting the environment variable
+ * \c DBUS_SYSTEM_BUS_ADDRESS before the first call of instance() points the
+ * Authority at another bus, e.g. a private bus running a stand-in for
+ * polkitd in tests.
  */
 class POLKITQT1_CORE_EXPORT Authority : public QObject
 {
@@ -104,10 +118,225 @@ public:
         /** Response of auth agent failed **/
         E_AgentResponseFailed = 0x09,
         /** Revoke temporary authorizations failed **/
-        E_RevokeFailed = 0x0A
+        E_RevokeFailed = 0x0A,
+        /** The check was rejected as too many checks were waiting, see setMaxQueuedChecks() **/
+        E_Overloaded = 0x0B,
+        /** The call did not finish in time, see setCallTimeout() **/
+        E_Timeout = 0x0C
     };
     Q_ENUM(ErrorCode)
 
+    /** Modes of the client side authorization decision cache */
+    enum CacheMode {
+        /** Every authorization check is sent to polkitd **/
+        CacheDisabled = 0x00,
+        /** \c Yes and \c No results are cached **/
+        CacheDecisions = 0x01,
+        /** \c Yes, \c No and \c Challenge results are cached **/
+        CacheDecisionsAndChallenges = 0x02
+    };
+    Q_ENUM(CacheMode)
+
+    /** Operations measured by the statistics of the authority */
+    enum Operation {
+        /** Single authorization checks, from all checkAuthorization methods **/
+        CheckAuthorizationOperation = 0x00,
+        /** Whole batches of checkAuthorizationBatch() and checkAuthorizationBatchSync() **/
+        CheckAuthorizationBatchOperation = 0x01,
+        /** Enumerating the registered actions **/
+        EnumerateActionsOperation = 0x02,
+        /** Registering an authentication agent **/
+        RegisterAuthenticationAgentOperation = 0x03,
+        /** Unregistering an authentication agent **/
+        UnregisterAuthenticationAgentOperation = 0x04,
+        /** Responses of an authentication agent **/
+        AuthenticationAgentResponseOperation = 0x05,
+        /** Enumerating temporary authorizations **/
+        EnumerateTemporaryAuthorizationsOperation = 0x06,
+        /** Revoking all temporary authorizations of a subject **/
+        RevokeTemporaryAuthorizationsOperation = 0x07,
+        /** Revoking a single temporary authorization **/
+        RevokeTemporaryAuthorizationOperation = 0x08
+    };
+    Q_ENUM(Operation)
+
+    /**
+     * \brief A single authorization check of a batch
+     *
+     * \see checkAuthorizationBatch
+     *
+     * \since 0.201
+     */
+    class CheckRequest
+    {
+    public:
+        CheckRequest() {}
+        CheckRequest(const QString &actionId, const Subject &subject, const DetailsMap &details = DetailsMap())
+            : actionId(actionId)
+            , subject(subject)
+            , details(details)
+        {
+        }
+
+        /** the Id of the action in question */
+        QString actionId;
+        /** subject that the action is authorized for (e.g. unix process) */
+        Subject subject;
+        /** see checkAuthorizationWithDetails() for a description of the details */
+        DetailsMap details;
+    };
+
+    /**
+     * \brief Outcome of a single authorization check, including its error
+     *
+     * Returned by the methods that report errors with every call instead of
+     * through the error state of the authority.
+     *
+     * \see checkAuthorizationResultSync
+     *
+     * \since 0.201
+     */
+    class CheckResult
+    {
+    public:
+        CheckResult() : result(Unknown), error(E_None) {}
+        CheckResult(Result result, ErrorCode error = E_None, const QString &errorDetails = QString())
+            : result(result)
+            , error(error)
+            , errorDetails(errorDetails)
+        {
+        }
+
+        /** \return \c true if the check failed, see error and errorDetails */
+        bool isError() const
+        {
+            return error != E_None;
+        }
+
+        /** result of the check, \c Unknown if it failed */
+        Result result;
+        /** why the check failed, \c E_None if it did not */
+        ErrorCode error;
+        /** detail message of the error */
+        QString errorDetails;
+        /**
+         * id of the temporary authorization the result is \c Yes because of,
+         * empty if there is none, see revokeTemporaryAuthorization()
+         */
+        QString temporaryAuthorizationId;
+    };
+
+    /**
+     * \brief Outcome of an enumeration of the actions, including its error
+     *
+     * Returned by the methods that report errors with every call instead of
+     * through the error state of the authority.
+     *
+     * \see enumerateActionsResultSync
+     *
+     * \since 0.201
+     */
+    class ActionsResult
+    {
+    public:
+        ActionsResult() : error(E_None) {}
+        ActionsResult(const ActionDescription::List &actions, ErrorCode error = E_None, const QString &errorDetails = QString())
+            : actions(actions)
+            , error(error)
+            , errorDetails(errorDetails)
+        {
+        }
+
+        /** \return \c true if the enumeration failed, see error and errorDetails */
+        bool isError() const
+        {
+            return error != E_None;
+        }
+
+        /** the registered actions, empty if the enumeration failed */
+        ActionDescription::List actions;
+        /** why the enumeration failed, \c E_None if it did not */
+        ErrorCode error;
+        /** detail message of the error */
+        QString errorDetails;
+    };
+
+    /**
+     * \brief Call counts and latencies of one operation
+     *
+     * Latencies are in microseconds, from the start of a call until its result
+     * is delivered, and include the time queued calls wait for the authority.
+     * The percentiles are estimated from a histogram of power of two buckets.
+     * Checks answered from the decision cache are not counted.
+     *
+     * \see statistics
+     *
+     * \since 0.201
+     */
+    class OperationStatistics
+    {
+    public:
+        OperationStatistics()
+            : calls(0), errors(0), cancellations(0), inFlight(0)
+            , p50(0), p95(0), p99(0), maxLatency(0)
+        {
+        }
+
+        /** finished calls, including failed and cancelled ones */
+        quint64 calls;
+        /** calls that failed */
+        quint64 errors;
+        /** calls that were cancelled */
+        quint64 cancellations;
+        /** calls started but not finished yet */
+        int inFlight;
+        /** median latency */
+        qint64 p50;
+        /** 95th percentile of the latency */
+        qint64 p95;
+        /** 99th percentile of the latency */
+        qint64 p99;
+        /** highest latency seen */
+        qint64 maxLatency;
+    };
+
+    /**
+     * \brief A change of a logind seat or session
+     *
+     * \see loginChanged
+     *
+     * \since 0.201
+     */
+    class LoginChange
+    {
+    public:
+        enum Kind {
+            /** A session was created **/
+            SessionAdded = 0x00,
+            /** A session was closed **/
+            SessionRemoved = 0x01,
+            /** Properties of a session changed, e.g. it became active **/
+            SessionChanged = 0x02,
+            /** A seat was added **/
+            SeatAdded = 0x03,
+            /** A seat was removed **/
+            SeatRemoved = 0x04,
+            /** Properties of a seat changed, e.g. its active session **/
+            SeatChanged = 0x05
+        };
+
+        LoginChange() : kind(SessionChanged) {}
+
+        /** what happened */
+        Kind kind;
+        /** the logind id of the session or seat, e.g. "c2" or "seat0" */
+        QString id;
+        /** the D-Bus object path of the session or seat */
+        QString objectPath;
+        /** for \c SessionChanged and \c SeatChanged, the names of the changed properties */
+        QStringList changedProperties;
+    };
+
     /**
      * \brief Returns the instance of Authority
      *
@@ -127,12 +356,52 @@ public:
      */
     static Authority *instance(PolkitAuthority *authority = nullptr);
 
+    /**
+     * \brief Returns the instance of Authority without blocking on polkitd
+     *
+     * Works like instance(), but if the authority still has to be created it
+     * connects to polkitd in the background instead of blocking the caller.
+     * isReady() returns \c false and ready() is emitted once it is connected.
+     *
+     * Asynchronous calls made in the meantime are queued and sent once the
+     * authority is ready. Synchronous calls, and polkitAuthority(), wait for it.
+     *
+     * \return The current authority instance
+     *
+     * \since 0.201
+     */
+    static Authority *instanceAsync();
+
     ~Authority() override;
 
+    /**
+     * \return \c true once the authority is connected to polkitd
+     *
+     * If the authority could not be looked up, it is \c false again for a
+     * moment while the lookup is repeated for a restarted polkitd, see
+     * reconnected().
+     *
+     * \see instanceAsync
+     * \see ready
+     *
+     * \since 0.201
+     */
+    bool isReady() const;
+
+    /**
+     * \return how many times the authority reconnected to polkitd
+     *
+     * \see reconnected
+     * \since 0.201
+     */
+    int reconnectCount() const;
+
     /**
      * You should always call this method after every action. No action will be allowed
      * if the object is in error state. Use clearError() to clear the error message.
      *
+     * The error state belongs to the calling thread.
+     *
      * \see lastError
      * \see clearError
      *
@@ -153,7 +422,7 @@ public:
     const QString errorDetails() const;
 
     /**
-     * Use this method to clear the error message.
+     * Use this method to clear the error message of the calling thread.
      */
     void clearError();
 
@@ -164,10 +433,265 @@ public:
      * modifies the instance on it, unless you're completely aware of what you're doing and
      * of the possible consequencies. Use this instance only to gather information.
      *
+     * If the authority is not ready yet, this waits until it is.
+     *
      * \return the current PolkitAuthority instance
      */
     PolkitAuthority *polkitAuthority() const;
 
+    /**
+     * Enables or disables the client side authorization decision cache. The cache is
+     * disabled by default.
+     *
+     * When enabled, checkAuthorizationSync() and checkAuthorizationAsync() remember
+     * the result for each combination of action id, subject, flags and details and
+     * answer repeated checks without a round trip to polkitd. Checks with
+     * \c AllowUserInteraction are never cached, and neither are results that
+     * are \c Yes only because of a temporary authorization, as it may expire
+     * any time. The cache is flushed whenever configChanged() or
+     * consoleKitDBChanged() is emitted, and when temporary authorizations are
+     * revoked through this authority.
+     *
+     * \note Only enable the cache if your subjects are short lived or if you can
+     * tolerate results that lag behind changes polkitd does not announce.
+     *
+     * \param mode which results should be cached
+     *
+     * \since 0.201
+     */
+    void setCacheMode(CacheMode mode);
+
+    /**
+     * \return the current mode of the decision cache
+     *
+     * \since 0.201
+     */
+    CacheMode cacheMode() const;
+
+    /**
+     * Drops all cached authorization decisions.
+     *
+     * \since 0.201
+     */
+    void clearCache();
+
+    /**
+     * \return how many authorization checks were answered from the decision cache
+     *
+     * \since 0.201
+     */
+    quint64 cacheHits() const;
+
+    /**
+     * \return how many cacheable authorization checks had to be sent to polkitd
+     *
+     * \since 0.201
+     */
+    quint64 cacheMisses() const;
+
+    /**
+     * Enables or disables the worker thread of the authority.
+     *
+     * By default the asynchronous methods issue their polkit calls from the
+     * thread the authority lives in, and their results only arrive when that
+     * thread runs a GLib based event dispatcher. With the worker thread
+     * enabled the calls are issued from a private thread running its own GLib
+     * main context, and the results are delivered back to the thread of the
+     * authority through its Qt event loop. This works with any event
+     * dispatcher, and a busy GLib main loop no longer delays the results.
+     *
+     * Disabling it only affects calls started afterwards. The synchronous
+     * methods are not affected.
+     *
+     * \param enabled \c true to issue asynchronous calls from the worker thread
+     *
+     * \since 0.201
+     */
+    void setWorkerThreadEnabled(bool enabled);
+
+    /**
+     * \return \c true if asynchronous calls are issued from the worker thread
+     *
+     * \see setWorkerThreadEnabled
+     * \since 0.201
+     */
+    bool isWorkerThreadEnabled() const;
+
+    /**
+     * Limits the number of asynchronous authorization checks sent to polkitd
+     * at the same time. The default of \c 0 sends every check right away.
+     *
+     * Checks started while the limit is reached wait in a queue and are sent
+     * in the order they were started, as soon as earlier checks finish. A
+     * burst of thousands of checks then takes longer instead of flooding
+     * polkitd until its replies time out. The time spent waiting counts as
+     * part of the latency in the statistics.
+     *
+     * This applies to checkAuthorization(), checkAuthorizationAsync(),
+     * checkAuthorizationResultAsync() and each check of checkAuthorizationBatch().
+     * Synchronous checks and the other methods are not limited.
+     *
+     * \param max the maximum number of checks waiting for polkitd
+     *
+     * \see setMaxQueuedChecks
+     * \since 0.201
+     */
+    void setMaxInFlightChecks(int max);
+
+    /**
+     * \return the maximum number of checks waiting for polkitd, \c 0 if unlimited
+     *
+     * \see setMaxInFlightChecks
+     * \since 0.201
+     */
+    int maxInFlightChecks() const;
+
+    /**
+     * Limits the number of checks waiting for one of the slots set by
+     * setMaxInFlightChecks(). The default of \c 0 lets the queue grow without
+     * limit.
+     *
+     * Checks started while the queue is full fail right away with
+     * \c E_Overloaded, so callers can shed load instead of piling it up.
+     *
+     * \param max the maximum number of queued checks
+     *
+     * \since 0.201
+     */
+    void setMaxQueuedChecks(int max);
+
+    /**
+     * \return the maximum number of queued checks, \c 0 if unlimited
+     *
+     * \see setMaxQueuedChecks
+     * \since 0.201
+     */
+    int maxQueuedChecks() const;
+
+    /**
+     * \return the number of checks currently sent to polkitd and waiting for a reply
+     *
+     * \see setMaxInFlightChecks
+     * \since 0.201
+     */
+    int inFlightChecks() const;
+
+    /**
+     * \return the number of checks currently waiting to be sent to polkitd
+     *
+     * \see setMaxInFlightChecks
+     * \since 0.201
+     */
+    int queuedChecks() const;
+
+    /**
+     * Bounds the time the synchronous methods and the QFuture based methods
+     * may take. The default of \c 0 leaves calls to the D-Bus timeout of
+     * about 25 seconds.
+     *
+     * A call still running once its timeout passed is cancelled, including
+     * the check on the side of polkitd, and fails with \c E_Timeout. Methods
+     * returning a CheckResult report it there, the others set it as the last
+     * error. The timeout counts from the moment the method is called, so time
+     * spent waiting for polkitd to become ready or in the queue of
+     * setMaxInFlightChecks() is part of it.
+     *
+     * Checks allowing user interaction wait for the user to authenticate and
+     * are never timed out, neither are the signal based methods, which have
+     * their own cancel methods.
+     *
+     * \param msec the timeout of every call in milliseconds
+     *
+     * \since 0.201
+     */
+    void setCallTimeout(int msec);
+
+    /**
+     * \return the timeout of calls in milliseconds, \c 0 if the D-Bus default applies
+     *
+     * \see setCallTimeout
+     * \since 0.201
+     */
+    int callTimeout() const;
+
+    /**
+     * Sets the quiet period used to coalesce change notifications. The default
+     * of \c 0 disables coalescing.
+     *
+     * Package upgrades or many logins at once can make polkitd, ConsoleKit and
+     * logind report hundreds of changes in a row, and every configChanged() and
+     * consoleKitDBChanged() makes each Gui::Action check its authorization again.
+     * With a quiet period set, changes are collected until none arrived for
+     * \p msec milliseconds, then each of these signals is emitted at most once,
+     * followed by authorizationsChanged(). Long bursts are still reported at
+     * least every ten quiet periods.
+     *
+     * The decision cache is always cleared right away.
+     *
+     * \param msec the quiet period in milliseconds
+     *
+     * \since 0.201
+     */
+    void setChangeCoalescingInterval(int msec);
+
+    /**
+     * \return the quiet period used to coalesce change notifications, in milliseconds
+     *
+     * \see setChangeCoalescingInterval
+     * \since 0.201
+     */
+    int changeCoalescingInterval() const;
+
+    /**
+     * \return the number of changes reported by polkitd, ConsoleKit and logind so far
+     *
+     * Compare it with the value passed by authorizationsChanged() to tell
+     * whether a result obtained in between may already be outdated.
+     *
+     * \since 0.201
+     */
+    quint64 changeGeneration() const;
+
+    /**
+     * Enables or disables the collection of call statistics. They are
+     * disabled by default, and cost next to nothing then.
+     *
+     * While enabled, every call to polkitd made by the authority, synchronous
+     * or not, is counted and timed per Operation. Disabling keeps the numbers
+     * collected so far.
+     *
+     * \param enabled \c true to collect statistics
+     *
+     * \see statistics
+     * \since 0.201
+     */
+    void setStatisticsEnabled(bool enabled);
+
+    /**
+     * \return \c true if call statistics are collected
+     *
+     * \see setStatisticsEnabled
+     * \since 0.201
+     */
+    bool isStatisticsEnabled() const;
+
+    /**
+     * \param operation the operation to report on
+     * \return the statistics collected for \p operation so far
+     *
+     * \see setStatisticsEnabled
+     * \since 0.201
+     */
+    OperationStatistics statistics(Operation operation) const;
+
+    /**
+     * Clears the collected statistics. Calls still running keep being counted
+     * as in flight.
+     *
+     * \since 0.201
+     */
+    void resetStatistics();
+
     /**
      * This function should be used by mechanisms (e.g.: helper applications).
      * It returns the action should be carried out, so if the caller was
@@ -210,6 +734,18 @@ public:
                             const QString &actionId, const Subject &subject,
                             AuthorizationFlags flags, const DetailsMap &details);
 
+    /**
+     * This function does the same as checkAuthorizationWithDetails(const
+     * QString&, const Subject&, AuthorizationFlags, const DetailsMap&), but
+     * takes Details. Details are converted for polkit once when they are
+     * built, while a DetailsMap is converted again on every call, so pass
+     * the same Details when checking with the same details many times.
+     *
+     * \since 0.201
+     */
+    void checkAuthorizationWithDetails(const QString &actionId, const Subject &subject,
+                                       AuthorizationFlags flags, const Details &details);
+
     /**
      * Synchronous version of the checkAuthorization method.
      *
@@ -234,11 +770,124 @@ public:
     Result checkAuthorizationSyncWithDetails(const QString &actionId, const Subject &subject,
                                   AuthorizationFlags flags, const DetailsMap &details);
 
+    /**
+     * This function does the same as checkAuthorizationSyncWithDetails(const
+     * QString&, const Subject&, AuthorizationFlags, const DetailsMap&), but
+     * takes Details, which are converted only once for any number of calls.
+     *
+     * \see checkAuthorizationWithDetails(const QString&, const Subject&, AuthorizationFlags, const Details&)
+     *
+     * \since 0.201
+     */
+    Result checkAuthorizationSyncWithDetails(const QString &actionId, const Subject &subject,
+                                             AuthorizationFlags flags, const Details &details);
+
     /**
      * This method can be used to cancel last authorization check.
      */
     void checkAuthorizationCancel();
 
+    /**
+     * Asynchronously checks the authorization like checkAuthorizationWithDetails(),
+     * but delivers the result through the returned future instead of the shared
+     * checkAuthorizationFinished() signal.
+     *
+     * Every call has its own cancellable, so any number of checks can be in flight
+     * at the same time and each result belongs to exactly one request. Call
+     * QFuture::cancel() on the returned future to cancel just this check.
+     *
+     * If the check fails the error is set as with checkAuthorization() and the
+     * future finishes with \c Unknown. A cancelled future carries no result.
+     *
+     * \param actionId the Id of the action in question
+     * \param subject subject that the action is authorized for (e.g. unix process)
+     * \param flags flags that influences the authorization checking
+     * \param details see checkAuthorizationWithDetails() for a description of the details parameter
+     *
+     * \return a future that finishes with the result of the authorization check
+     *
+     * \since 0.201
+     */
+    QFuture<Result> checkAuthorizationAsync(const QString &actionId, const Subject &subject,
+                                            AuthorizationFlags flags, const DetailsMap &details = DetailsMap());
+
+    /**
+     * Synchronously checks the authorization like checkAuthorizationSyncWithDetails(),
+     * but returns the error of the check with its result.
+     *
+     * This method neither looks at nor changes the error state of the authority,
+     * so a failed check does not block any other call and there is no need to
+     * call hasError() or clearError() afterwards.
+     *
+     * \param actionId the Id of the action in question
+     * \param subject subject that the action is authorized for (e.g. unix process)
+     * \param flags flags that influences the authorization checking
+     * \param details see checkAuthorizationWithDetails() for a description of the details parameter
+     *
+     * \return the result of the authorization check, or the reason it failed
+     *
+     * \see checkAuthorizationResultAsync Asynchronous version of this method.
+     *
+     * \since 0.201
+     */
+    CheckResult checkAuthorizationResultSync(const QString &actionId, const Subject &subject,
+                                             AuthorizationFlags flags, const DetailsMap &details = DetailsMap());
+
+    /**
+     * Asynchronous version of the checkAuthorizationResultSync method. Like
+     * checkAuthorizationAsync(), every call can be cancelled on its own through
+     * the returned future.
+     *
+     * \param actionId the Id of the action in question
+     * \param subject subject that the action is authorized for (e.g. unix process)
+     * \param flags flags that influences the authorization checking
+     * \param details see checkAuthorizationWithDetails() for a description of the details parameter
+     *
+     * \return a future that finishes with the result of the authorization check, or the reason it failed
+     *
+     * \since 0.201
+     */
+    QFuture<CheckResult> checkAuthorizationResultAsync(const QString &actionId, const Subject &subject,
+                                                       AuthorizationFlags flags, const DetailsMap &details = DetailsMap());
+
+    /**
+     * Checks a whole list of authorizations at once, e.g. many actions for the same
+     * subject or one action for many subjects.
+     *
+     * All checks are sent to polkitd concurrently, so the batch takes about as long
+     * as a single round trip instead of one round trip per check. The returned future
+     * finishes once every check has been answered; cancelling it cancels all checks
+     * still in flight.
+     *
+     * Every check reports its own error with its result, see CheckResult. Like
+     * checkAuthorizationResultSync(), batches neither look at nor change the error
+     * state of the authority.
+     *
+     * \see checkAuthorizationBatchSync Synchronous version of this method.
+     *
+     * \param requests the checks to perform
+     * \param flags flags that influences the authorization checking, applied to every check
+     *
+     * \return a future that finishes with one result per request, in the order of \p requests
+     *
+     * \since 0.201
+     */
+    QFuture<QVector<CheckResult> > checkAuthorizationBatch(const QList<CheckRequest> &requests, AuthorizationFlags flags);
+
+    /**
+     * Synchronous version of the checkAuthorizationBatch method.
+     *
+     * \param requests the checks to perform
+     * \param flags flags that influences the authorization checking, applied to every check
+     *
+     * \return one result per request, in the order of \p requests
+     *
+     * \see checkAuthorizationBatch Asynchronous version of this method.
+     *
+     * \since 0.201
+     */
+    QVector<CheckResult> checkAuthorizationBatchSync(const QList<CheckRequest> &requests, AuthorizationFlags flags);
+
     /**
      * Asynchronously retrieves all registered actions.
      *
@@ -265,6 +914,62 @@ public:
      */
     void enumerateActionsCancel();
 
+    /**
+     * Asynchronously retrieves all registered actions, delivering them in
+     * chunks of \p chunkSize actions through enumerateActionsChunkReady().
+     * Each chunk is converted right before it is emitted, and the event loop
+     * runs between two chunks, so a view can show the first actions before
+     * the others are converted and no signal carries the whole list.
+     *
+     * Every call ends with enumerateActionsChunkedFinished(): after the last
+     * chunk, when enumerateActionsCancel() stopped it, or when the enumeration
+     * failed. Unlike enumerateActions(), it also starts while the authority
+     * is in the error state.
+     *
+     * \param chunkSize the maximum number of actions per chunk
+     *
+     * \since 0.201
+     */
+    void enumerateActionsChunked(int chunkSize = 64);
+
+    /**
+     * Asynchronously retrieves all registered actions. Unlike enumerateActions(),
+     * the result is delivered through the returned future, which can also be used
+     * to cancel this particular call.
+     *
+     * \return a future that finishes with the list of all registered actions
+     *
+     * \since 0.201
+     */
+    QFuture<ActionDescription::List> enumerateActionsAsync();
+
+    /**
+     * Synchronously retrieves all registered actions like enumerateActionsSync(),
+     * but returns the error of the enumeration with the actions.
+     *
+     * This method neither looks at nor changes the error state of the authority,
+     * so a failed enumeration is told from one without actions and does not
+     * block any other call.
+     *
+     * \return the registered actions, or the reason the enumeration failed
+     *
+     * \see enumerateActionsResultAsync Asynchronous version of this method.
+     *
+     * \since 0.201
+     */
+    ActionsResult enumerateActionsResultSync();
+
+    /**
+     * Asynchronous version of the enumerateActionsResultSync method. Like
+     * enumerateActionsAsync(), every call can be cancelled on its own through
+     * the returned future.
+     *
+     * \return a future that finishes with the registered actions, or the reason the enumeration failed
+     *
+     * \since 0.201
+     */
+    QFuture<ActionsResult> enumerateActionsResultAsync();
+
     /**
      * Registers an authentication agent.
      *
@@ -299,6 +1004,21 @@ public:
      */
     void registerAuthenticationAgentCancel();
 
+    /**
+     * Registers an authentication agent, delivering the result through the
+     * returned future instead of registerAuthenticationAgentFinished().
+     *
+     * \param subject caller subject
+     * \param locale the locale of the authentication agent
+     * \param objectPath the object path for the authentication agent
+     *
+     * \return a future that finishes with \c true if the agent has been registered
+     *
+     * \since 0.201
+     */
+    QFuture<bool> registerAuthenticationAgentAsync(const Subject &subject, const QString &locale,
+                                                   const QString &objectPath);
+
     /**
      * Unregisters an Authentication agent.
      *
@@ -332,6 +1052,19 @@ public:
      */
     void unregisterAuthenticationAgentCancel();
 
+    /**
+     * Unregisters an authentication agent, delivering the result through the
+     * returned future instead of unregisterAuthenticationAgentFinished().
+     *
+     * \param subject caller subject
+     * \param objectPath the object path for the Authentication agent
+     *
+     * \return a future that finishes with \c true if the agent has been unregistered
+     *
+     * \since 0.201
+     */
+    QFuture<bool> unregisterAuthenticationAgentAsync(const Subject &subject, const QString &objectPath);
+
     /**
      * Provide response that \p identity successfully authenticated for the authentication request identified by \p cookie.
      *
@@ -362,6 +1095,20 @@ public:
      */
     void authenticationAgentResponseCancel();
 
+    /**
+     * Provide response that \p identity successfully authenticated for the authentication
+     * request identified by \p cookie, delivering the result through the returned future
+     * instead of authenticationAgentResponseFinished().
+     *
+     * \param cookie The cookie passed to the authentication agent from the authority.
+     * \param identity The identity that was authenticated.
+     *
+     * \return a future that finishes with \c true if authority acknowledged the call
+     *
+     * \since 0.201
+     */
+    QFuture<bool> authenticationAgentResponseAsync(const QString &cookie, const Identity &identity);
+
     /**
      * Retrieves all temporary action that applies to \p subject.
      *
@@ -392,6 +1139,18 @@ public:
      */
     void enumerateTemporaryAuthorizationsCancel();
 
+    /**
+     * Retrieves all temporary action that applies to \p subject, delivering the result
+     * through the returned future instead of enumerateTemporaryAuthorizationsFinished().
+     *
+     * \param subject the subject to get temporary authorizations for
+     *
+     * \return a future that finishes with the list of all temporary authorizations
+     *
+     * \since 0.201
+     */
+    QFuture<TemporaryAuthorization::List> enumerateTemporaryAuthorizationsAsync(const Subject &subject);
+
     /**
      * Revokes all temporary authorizations that applies to \p subject
      *
@@ -420,6 +1179,18 @@ public:
      */
     void revokeTemporaryAuthorizationsCancel();
 
+    /**
+     * Revokes all temporary authorizations that applies to \p subject, delivering the
+     * result through the returned future instead of revokeTemporaryAuthorizationsFinished().
+     *
+     * \param subject the subject to revoke temporary authorizations from
+     *
+     * \return a future that finishes with \c true if all temporary authorizations were revoked
+     *
+     * \since 0.201
+     */
+    QFuture<bool> revokeTemporaryAuthorizationsAsync(const Subject &subject);
+
     /**
      * Revokes temporary authorization by \p id
      *
@@ -448,6 +1219,18 @@ public:
      */
     void revokeTemporaryAuthorizationCancel();
 
+    /**
+     * Revokes temporary authorization by \p id, delivering the result through the
+     * returned future instead of revokeTemporaryAuthorizationFinished().
+     *
+     * \param id the identifier of the temporary authorization
+     *
+     * \return a future that finishes with \c true if the temporary authorization was revoked
+     *
+     * \since 0.201
+     */
+    QFuture<bool> revokeTemporaryAuthorizationAsync(const QString &id);
+
 Q_SIGNALS:
     /**
      * This signal will be emitted when a configuration
@@ -469,9 +1252,59 @@ Q_SIGNALS:
      *
      * \note If you use Action you'll probably prefer to
      * use the dataChanged() signal to track Action changes.
+     *
+     * It is also emitted for the logind changes that can affect authorizations,
+     * see loginChanged().
      */
     void consoleKitDBChanged();
 
+    /**
+     * This signal is emitted when logind reports a change of one of its seats
+     * or sessions. Unlike consoleKitDBChanged() it tells what changed, so
+     * receivers can limit their work to the affected seat or session.
+     *
+     * \param change the seat or session that changed and how
+     *
+     * \since 0.201
+     */
+    void loginChanged(const PolkitQt1::Authority::LoginChange &change);
+
+    /**
+     * This signal is emitted after configChanged() or consoleKitDBChanged(),
+     * once per burst of changes when they are coalesced.
+     *
+     * \param generation the change generation the notification covers, see changeGeneration()
+     *
+     * \see setChangeCoalescingInterval
+     * \since 0.201
+     */
+    void authorizationsChanged(quint64 generation);
+
+    /**
+     * This signal is emitted once the authority is connected to polkitd and
+     * the calls queued until then have been sent.
+     *
+     * \see instanceAsync
+     *
+     * \since 0.201
+     */
+    void ready();
+
+    /**
+     * This signal is emitted once the authority reconnected to polkitd after
+     * it restarted, e.g. during a package upgrade.
+     *
+     * Calls started while reconnecting are queued and sent to the new
+     * polkitd. The decision cache is flushed, configChanged() is emitted as
+     * the new polkitd may decide differently, and the error state of every
+     * thread is cleared, so clients no longer stay in an error state caused
+     * by the old polkitd.
+     *
+     * \see reconnectCount
+     * \since 0.201
+     */
+    void reconnected();
+
     /**
      * This signal is emitted when asynchronous method checkAuthorization finishes.
      *
@@ -486,6 +1319,26 @@ Q_SIGNALS:
      */
     void enumerateActionsFinished(PolkitQt1::ActionDescription::List);
 
+    /**
+     * This signal is emitted for every chunk of actions retrieved by
+     * enumerateActionsChunked(), in the order polkitd listed them.
+     *
+     * \since 0.201
+     */
+    void enumerateActionsChunkReady(PolkitQt1::ActionDescription::List);
+
+    /**
+     * This signal ends every call of enumerateActionsChunked(). It is emitted
+     * after the last chunk, also if there were no actions at all, or instead
+     * of the remaining chunks if the call failed or was cancelled.
+     *
+     * \param error why the enumeration failed, \c E_None if it did not
+     * \param cancelled \c true if enumerateActionsCancel() stopped the call
+     *
+     * \since 0.201
+     */
+    void enumerateActionsChunkedFinished(PolkitQt1::Authority::ErrorCode error, bool cancelled);
+
     /**
      * This signal is emitted when asynchronous method registerAuthenticationAgent finishes.
      *
@@ -541,10 +1394,15 @@ private:
     Private * const d;
 
     Q_PRIVATE_SLOT(d, void dbusFilter(const QDBusMessage &message))
+    Q_PRIVATE_SLOT(d, void loginFilter(const QDBusMessage &message))
+    Q_PRIVATE_SLOT(d, void polkitOwnerChanged(const QString &name, const QString &oldOwner, const QString &newOwner))
+    Q_PRIVATE_SLOT(d, void reconnect())
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Authority::AuthorizationFlags)
 
 }
 
+Q_DECLARE_METATYPE(PolkitQt1::Authority::LoginChange)
+
 #endif
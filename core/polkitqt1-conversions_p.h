@@ -0,0 +1,46 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_CONVERSIONS_P_H
+#define POLKITQT1_CONVERSIONS_P_H
+
+#include "polkitqt1-authority.h"
+#include "polkitqt1-details.h"
+
+typedef struct _GList GList;
+
+// Conversions between polkit-gobject and Qt types done by Authority on every
+// call. Not part of the API, the benchmarks in test/ reach them through the
+// static build of the library.
+
+namespace PolkitQt1
+{
+
+/**
+ * \internal
+ * \brief Convert a Qt DetailsMap to the lower level PolkitDetails type
+ *
+ * The returned pointer needs to be freed via g_object_unref when no
+ * longer needed. Returns nullptr if details is empty.
+ */
+PolkitDetails *convertDetailsMap(const DetailsMap &details);
+
+/**
+ * \internal
+ * Converts a list of PolkitActionDescription, then unrefs its elements and frees it.
+ */
+ActionDescription::List actionsToListAndFree(GList *glist);
+
+/**
+ * \internal
+ * Converts a list of PolkitTemporaryAuthorization, which takes over the
+ * references of its elements, and frees it.
+ */
+TemporaryAuthorization::List temporaryAuthorizationsToListAndFree(GList *glist);
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-dbusauthority_p.h"
+#include "polkitqt1-actiondescription_p.h"
+
+#include <QAtomicInt>
+#include <QDBusArgument>
+#include <QDBusMetaType>
+
+#include <climits>
+
+#include <polkit/polkit.h>
+
+namespace PolkitQt1
+{
+
+static const char s_polkitService[] = "org.freedesktop.PolicyKit1";
+static const char s_polkitPath[] = "/org/freedesktop/PolicyKit1/Authority";
+static const char s_polkitInterface[] = "org.freedesktop.PolicyKit1.Authority";
+
+/**
+ * Marshals \p subject as the (sa{sv}) structure polkitd expects.
+ */
+static QDBusArgument subjectToArgument(const Subject &subject)
+{
+    PolkitSubject *pkSubject = subject.subject();
+    QString kind;
+    QVariantMap details;
+
+    if (POLKIT_IS_UNIX_PROCESS(pkSubject)) {
+        PolkitUnixProcess *process = POLKIT_UNIX_PROCESS(pkSubject);
+        kind = QStringLiteral("unix-process");
+        details.insert(QStringLiteral("pid"), quint32(polkit_unix_process_get_pid(process)));
+        details.insert(QStringLiteral("start-time"), quint64(polkit_unix_process_get_start_time(process)));
+        if (polkit_unix_process_get_uid(process) != -1) {
+            details.insert(QStringLiteral("uid"), qint32(polkit_unix_process_get_uid(process)));
+        }
+    } else if (POLKIT_IS_UNIX_SESSION(pkSubject)) {
+        kind = QStringLiteral("unix-session");
+        details.insert(QStringLiteral("session-id"),
+                       QString::fromUtf8(polkit_unix_session_get_session_id(POLKIT_UNIX_SESSION(pkSubject))));
+    } else if (POLKIT_IS_SYSTEM_BUS_NAME(pkSubject)) {
+        kind = QStringLiteral("system-bus-name");
+        details.insert(QStringLiteral("name"),
+                       QString::fromUtf8(polkit_system_bus_name_get_name(POLKIT_SYSTEM_BUS_NAME(pkSubject))));
+    }
+
+    QDBusArgument argument;
+    argument.beginStructure();
+    argument << kind << details;
+    argument.endStructure();
+    return argument;
+}
+
+/**
+ * Creates a new PolkitSubject from the (sa{sv}) structure sent by polkitd.
+ * The caller owns the returned reference.
+ */
+static PolkitSubject *subjectFromArgument(const QDBusArgument &argument)
+{
+    QString kind;
+    QVariantMap details;
+    argument.beginStructure();
+    argument >> kind >> details;
+    argument.endStructure();
+
+    if (kind == QLatin1String("unix-process")) {
+        return polkit_unix_process_new_for_owner(details.value(QStringLiteral("pid")).toUInt(),
+                                                 details.value(QStringLiteral("start-time")).toULongLong(),
+                                                 details.value(QStringLiteral("uid"), -1).toInt());
+    } else if (kind == QLatin1String("unix-session")) {
+        return polkit_unix_session_new(details.value(QStringLiteral("session-id")).toString().toUtf8().constData());
+    } else if (kind == QLatin1String("system-bus-name")) {
+        return polkit_system_bus_name_new(details.value(QStringLiteral("name")).toString().toUtf8().constData());
+    }
+
+    return nullptr;
+}
+
+DBusAuthority::DBusAuthority(const QDBusConnection &bus)
+        : m_bus(bus)
+{
+    qDBusRegisterMetaType<DetailsMap>();
+}
+
+QDBusMessage DBusAuthority::methodCall(const QString &method) const
+{
+    return QDBusMessage::createMethodCall(QLatin1String(s_polkitService), QLatin1String(s_polkitPath),
+                                          QLatin1String(s_polkitInterface), method);
+}
+
+QDBusPendingCall DBusAuthority::checkAuthorization(const QString &actionId, const Subject &subject,
+                                                   Authority::AuthorizationFlags flags, const DetailsMap &details,
+                                                   const QString &cancellationId, int timeout) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("CheckAuthorization"));
+    message << QVariant::fromValue(subjectToArgument(subject))
+            << actionId
+            << QVariant::fromValue(details)
+            << quint32(flags)
+            << cancellationId;
+    // Interactive checks wait for the user, don't let them time out
+    return m_bus.asyncCall(message, (flags & Authority::AllowUserInteraction) ? INT_MAX : timeout);
+}
+
+void DBusAuthority::cancelCheckAuthorization(const QString &cancellationId) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("CancelCheckAuthorization"));
+    message << cancellationId;
+    m_bus.send(message);
+}
+
+QDBusPendingCall DBusAuthority::enumerateActions(int timeout) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("EnumerateActions"));
+    // Same as polkit-gobject, which does not pass a locale either
+    message << QString();
+    return m_bus.asyncCall(message, timeout);
+}
+
+QDBusPendingCall DBusAuthority::enumerateTemporaryAuthorizations(const Subject &subject, int timeout) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("EnumerateTemporaryAuthorizations"));
+    message << QVariant::fromValue(subjectToArgument(subject));
+    return m_bus.asyncCall(message, timeout);
+}
+
+QDBusPendingCall DBusAuthority::revokeTemporaryAuthorizations(const Subject &subject, int timeout) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("RevokeTemporaryAuthorizations"));
+    message << QVariant::fromValue(subjectToArgument(subject));
+    return m_bus.asyncCall(message, timeout);
+}
+
+QDBusPendingCall DBusAuthority::revokeTemporaryAuthorizationById(const QString &id, int timeout) const
+{
+    QDBusMessage message = methodCall(QStringLiteral("RevokeTemporaryAuthorizationById"));
+    message << id;
+    return m_bus.asyncCall(message, timeout);
+}
+
+bool DBusAuthority::connectChanged(QObject *receiver, const char *slot)
+{
+    return m_bus.connect(QLatin1String(s_polkitService), QLatin1String(s_polkitPath),
+                         QLatin1String(s_polkitInterface), QStringLiteral("Changed"),
+                         receiver, slot);
+}
+
+bool DBusAuthority::isChangedSignal(const QDBusMessage &message)
+{
+    return message.interface() == QLatin1String(s_polkitInterface)
+           && message.member() == QLatin1String("Changed");
+}
+
+QString DBusAuthority::newCancellationId()
+{
+    static QAtomicInt s_lastId;
+    return QStringLiteral("polkit-qt-%1").arg(s_lastId.fetchAndAddRelaxed(1) + 1);
+}
+
+bool DBusAuthority::isTimeout(const QDBusError &error)
+{
+    return error.type() == QDBusError::NoReply || error.type() == QDBusError::Timeout;
+}
+
+Authority::Result DBusAuthority::checkAuthorizationResult(const QDBusMessage &reply, QString *temporaryAuthorizationId)
+{
+    if (reply.arguments().isEmpty()) {
+        return Authority::Unknown;
+    }
+
+    bool isAuthorized = false;
+    bool isChallenge = false;
+    DetailsMap resultDetails;
+
+    const QDBusArgument argument = reply.arguments().at(0).value<QDBusArgument>();
+    argument.beginStructure();
+    argument >> isAuthorized >> isChallenge >> resultDetails;
+    argument.endStructure();
+
+    if (temporaryAuthorizationId) {
+        *temporaryAuthorizationId = resultDetails.value(QStringLiteral("polkit.temporary_authorization_id"));
+    }
+
+    if (isChallenge) {
+        return Authority::Challenge;
+    } else if (isAuthorized) {
+        return Authority::Yes;
+    } else {
+        return Authority::No;
+    }
+}
+
+ActionDescription::List DBusAuthority::actionDescriptions(const QDBusMessage &reply)
+{
+    if (reply.arguments().isEmpty()) {
+        return ActionDescription::List();
+    }
+
+    ActionDescriptionListBuilder builder;
+    const QDBusArgument argument = reply.arguments().at(0).value<QDBusArgument>();
+    argument.beginArray();
+    while (readActionDescription(argument, &builder)) {
+    }
+    argument.endArray();
+
+    return builder.take();
+}
+
+bool DBusAuthority::readActionDescription(const QDBusArgument &argument, ActionDescriptionListBuilder *builder)
+{
+    if (argument.atEnd()) {
+        return false;
+    }
+
+    QString actionId, description, message, vendorName, vendorUrl, iconName;
+    quint32 implicitAny, implicitInactive, implicitActive;
+    DetailsMap annotations;
+
+    argument.beginStructure();
+    argument >> actionId
+             >> description
+             >> message
+             >> vendorName
+             >> vendorUrl
+             >> iconName
+             >> implicitAny
+             >> implicitInactive
+             >> implicitActive
+             >> annotations;
+    argument.endStructure();
+
+    builder->add(actionId, description, message, vendorName, vendorUrl, iconName,
+                 implicitAny, implicitInactive, implicitActive);
+    return true;
+}
+
+TemporaryAuthorization::List DBusAuthority::temporaryAuthorizations(const QDBusMessage &reply)
+{
+    TemporaryAuthorization::List result;
+    if (reply.arguments().isEmpty()) {
+        return result;
+    }
+
+    const QDBusArgument argument = reply.arguments().at(0).value<QDBusArgument>();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        QString id;
+        QString actionId;
+        quint64 timeObtained, timeExpires;
+
+        argument.beginStructure();
+        argument >> id >> actionId;
+        PolkitSubject *subject = subjectFromArgument(argument);
+        argument >> timeObtained >> timeExpires;
+        argument.endStructure();
+
+        if (subject == nullptr) {
+            continue;
+        }
+
+        // TemporaryAuthorization takes over the reference of the new object
+        result.append(TemporaryAuthorization(polkit_temporary_authorization_new(id.toUtf8().constData(),
+                                                                                actionId.toUtf8().constData(),
+                                                                                subject,
+                                                                                timeObtained,
+                                                                                timeExpires)));
+        g_object_unref(subject);
+    }
+    argument.endArray();
+
+    return result;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_DBUSAUTHORITY_P_H
+#define POLKITQT1_DBUSAUTHORITY_P_H
+
+#include "polkitqt1-authority.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+
+namespace PolkitQt1
+{
+
+class ActionDescriptionListBuilder;
+
+/**
+ * \internal
+ * \brief Direct QtDBus client of org.freedesktop.PolicyKit1.Authority
+ *
+ * Used by Authority instead of polkit-gobject when polkit-qt is built with
+ * USE_QTDBUS_BACKEND. It only marshals calls and replies, error handling and
+ * bookkeeping stay in Authority.
+ */
+class Q_DECL_HIDDEN DBusAuthority
+{
+public:
+    explicit DBusAuthority(const QDBusConnection &bus);
+
+    // A timeout of -1 milliseconds uses the default of QtDBus, interactive checks never time out
+    QDBusPendingCall checkAuthorization(const QString &actionId, const Subject &subject,
+                                        Authority::AuthorizationFlags flags, const DetailsMap &details,
+                                        const QString &cancellationId = QString(), int timeout = -1) const;
+    void cancelCheckAuthorization(const QString &cancellationId) const;
+    QDBusPendingCall enumerateActions(int timeout = -1) const;
+    QDBusPendingCall enumerateTemporaryAuthorizations(const Subject &subject, int timeout = -1) const;
+    QDBusPendingCall revokeTemporaryAuthorizations(const Subject &subject, int timeout = -1) const;
+    QDBusPendingCall revokeTemporaryAuthorizationById(const QString &id, int timeout = -1) const;
+
+    /**
+     * Connects \p slot of \p receiver to the Changed signal of polkitd.
+     */
+    bool connectChanged(QObject *receiver, const char *slot);
+
+    /**
+     * Returns \c true if \p message is the Changed signal of polkitd.
+     */
+    static bool isChangedSignal(const QDBusMessage &message);
+
+    /**
+     * Returns a new cancellation id for checkAuthorization(), unique within this process.
+     */
+    static QString newCancellationId();
+
+    /**
+     * Returns \c true if \p error is the one of a call that got no reply in time.
+     */
+    static bool isTimeout(const QDBusError &error);
+
+    /**
+     * Returns the result of a CheckAuthorization \p reply, and the id of the
+     * temporary authorization it is based on in \p temporaryAuthorizationId.
+     */
+    static Authority::Result checkAuthorizationResult(const QDBusMessage &reply, QString *temporaryAuthorizationId = nullptr);
+    static ActionDescription::List actionDescriptions(const QDBusMessage &reply);
+    // Reads the next element of the array of actions \p argument is in, false after the last one
+    static bool readActionDescription(const QDBusArgument &argument, ActionDescriptionListBuilder *builder);
+    static TemporaryAuthorization::List temporaryAuthorizations(const QDBusMessage &reply);
+
+private:
+    QDBusMessage methodCall(const QString &method) const;
+
+    QDBusConnection m_bus;
+};
+
+}
+
+#endif
@@ -0,0 +1,10 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-debug_p.h"
+
+// Only warnings are shown by default, enable the rest with QT_LOGGING_RULES
+Q_LOGGING_CATEGORY(POLKITQT1_CORE, "polkit-qt-1.core", QtWarningMsg)
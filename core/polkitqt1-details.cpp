@@ -21,6 +21,7 @@ public:
     Data(const Data &other)
         : QSharedData(other)
         , polkitDetails(other.polkitDetails)
+        , map(other.map)
     {
         if (polkitDetails != nullptr) {
             g_object_ref(polkitDetails);
@@ -34,6 +35,8 @@ public:
     }
 
     PolkitDetails *polkitDetails;
+    // The entries of polkitDetails, so that they need not be converted back
+    QMap<QString, QString> map;
 };
 
 Details::Details()
@@ -49,6 +52,22 @@ Details::Details(PolkitDetails *pkDetails)
     
     if (d->polkitDetails != nullptr) {
         g_object_ref(d->polkitDetails);
+
+        gchar **keys = polkit_details_get_keys(d->polkitDetails);
+        for (gchar **key = keys; key && *key; ++key) {
+            d->map.insert(QString::fromUtf8(*key), QString::fromUtf8(polkit_details_lookup(d->polkitDetails, *key)));
+        }
+        g_strfreev(keys);
+    }
+}
+
+Details::Details(const QMap<QString, QString> &map)
+        : d(new Data)
+{
+    d->polkitDetails = polkit_details_new();
+    d->map = map;
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        polkit_details_insert(d->polkitDetails, it.key().toUtf8().constData(), it.value().toUtf8().constData());
     }
 }
 
@@ -77,6 +96,7 @@ QString Details::lookup(const QString &key) const
 void Details::insert(const QString &key, const QString &value)
 {
     polkit_details_insert(d->polkitDetails, key.toUtf8().data(), value.toUtf8().data());
+    d->map.insert(key, value);
 }
 
 QStringList Details::keys() const
@@ -91,4 +111,14 @@ QStringList Details::keys() const
     return list;
 }
 
+QMap<QString, QString> Details::toMap() const
+{
+    return d->map;
+}
+
+PolkitDetails *Details::details() const
+{
+    return d->polkitDetails;
+}
+
 }
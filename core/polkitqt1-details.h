@@ -10,6 +10,7 @@
 
 #include "polkitqt1-core-export.h"
 
+#include <QMap>
 #include <QObject>
 #include <QSharedData>
 
@@ -30,6 +31,11 @@ namespace PolkitQt1
  * \author Radek Novacek <rnovacek@redhat.com>
  *
  * \brief Class used for passing details around.
+ *
+ * Details are converted to the form polkit needs when they are built. Pass
+ * the same Details to Authority::checkAuthorizationWithDetails() or
+ * Authority::checkAuthorizationSyncWithDetails() for repeated checks instead
+ * of a DetailsMap, which is converted again for every check.
  */
 class POLKITQT1_CORE_EXPORT Details
 {
@@ -48,6 +54,13 @@ public:
      */
     explicit Details(PolkitDetails *pkDetails);
 
+    /**
+     * Creates Details holding the entries of \p map
+     *
+     * \since 0.201
+     */
+    explicit Details(const QMap<QString, QString> &map);
+
     /**
      * Copy constructor.
      */
@@ -79,6 +92,26 @@ public:
      * \return List of all keys.
      */
     QStringList keys() const;
+
+    /**
+     * \return all entries
+     *
+     * \since 0.201
+     */
+    QMap<QString, QString> toMap() const;
+
+    /**
+     * Gets PolkitDetails object.
+     *
+     * \warning It shouldn't be used directly unless you are completely aware of what are you doing.
+     *          Entries inserted through it are not seen by toMap().
+     *
+     * \return Pointer to PolkitDetails instance
+     *
+     * \since 0.201
+     */
+    PolkitDetails *details() const;
+
 private:
     class Data;
     QExplicitlySharedDataPointer< Data > d;
@@ -6,10 +6,10 @@
 */
 
 #include "polkitqt1-identity.h"
+#include "polkitqt1-debug_p.h"
 
 #include <polkit/polkit.h>
 
-#include <QDebug>
 
 namespace PolkitQt1
 {
@@ -105,7 +105,7 @@ Identity Identity::fromString(const QString &string)
     GError *error = nullptr;
     PolkitIdentity *pkIdentity = polkit_identity_from_string(string.toUtf8().data(), &error);
     if (error != nullptr) {
-        qWarning() << QString("Cannot create Identity from string: %1").arg(error->message);
+        qCWarning(POLKITQT1_CORE) << "Cannot create Identity from string:" << error->message;
         return Identity();
     }
     return Identity(pkIdentity);
@@ -137,7 +137,7 @@ UnixUserIdentity::UnixUserIdentity(const QString &name)
     GError *error = nullptr;
     setIdentity(polkit_unix_user_new_for_name(name.toUtf8().data(), &error));
     if (error != nullptr) {
-        qWarning() << QString("Cannot create UnixUserIdentity: %1").arg(error->message);
+        qCWarning(POLKITQT1_CORE) << "Cannot create UnixUserIdentity:" << error->message;
         setIdentity(nullptr);
     }
 }
@@ -176,7 +176,7 @@ UnixGroupIdentity::UnixGroupIdentity(const QString &name)
     GError *error = nullptr;
     setIdentity(polkit_unix_group_new_for_name(name.toUtf8().data(), &error));
     if (error != nullptr) {
-        qWarning() << QString("Cannot create UnixGroupIdentity: %1").arg(error->message);
+        qCWarning(POLKITQT1_CORE) << "Cannot create UnixGroupIdentity:" << error->message;
         setIdentity(nullptr);
     }
 }
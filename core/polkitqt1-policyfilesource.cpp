@@ -0,0 +1,393 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-policyfilesource.h"
+#include "polkitqt1-actiondescription_p.h"
+#include "polkitqt1-actionsnapshot_p.h"
+#include "polkitqt1-debug_p.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QMap>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <climits>
+
+namespace PolkitQt1
+{
+
+namespace
+{
+
+// A text of a .policy file, translated to the best language found so far
+struct Translated
+{
+    Translated()
+        : rank(INT_MAX)
+    {
+    }
+
+    /**
+     * Takes \p value if \p lang matches \p languages better than the current
+     * text. The untranslated text ranks behind all matching translations.
+     */
+    void offer(const QString &lang, const QString &value, const QStringList &languages)
+    {
+        const int valueRank = lang.isEmpty() ? languages.size() : languages.indexOf(lang);
+        if (valueRank >= 0 && valueRank < rank) {
+            text = value;
+            rank = valueRank;
+        }
+    }
+
+    QString text;
+    int rank;
+};
+
+struct PolicyDefaults
+{
+    QString vendorName;
+    QString vendorUrl;
+    QString iconName;
+};
+
+int implicitAuthorization(const QString &value)
+{
+    if (value == QLatin1String("yes")) {
+        return ActionDescription::Authorized;
+    } else if (value == QLatin1String("auth_self")) {
+        return ActionDescription::AuthenticationRequired;
+    } else if (value == QLatin1String("auth_admin")) {
+        return ActionDescription::AdministratorAuthenticationRequired;
+    } else if (value == QLatin1String("auth_self_keep")) {
+        return ActionDescription::AuthenticationRequiredRetained;
+    } else if (value == QLatin1String("auth_admin_keep")) {
+        return ActionDescription::AdministratorAuthenticationRequiredRetained;
+    }
+    return ActionDescription::NotAuthorized;
+}
+
+void parseAction(QXmlStreamReader &xml, const PolicyDefaults &defaults, const QStringList &languages,
+                 ActionDescriptionListBuilder *builder)
+{
+    const QString actionId = xml.attributes().value(QLatin1String("id")).toString();
+    PolicyDefaults overrides = defaults;
+    Translated description;
+    Translated message;
+    int implicitAny = ActionDescription::NotAuthorized;
+    int implicitInactive = ActionDescription::NotAuthorized;
+    int implicitActive = ActionDescription::NotAuthorized;
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("description") || xml.name() == QLatin1String("message")) {
+            Translated &text = xml.name() == QLatin1String("description") ? description : message;
+            const QString lang = xml.attributes().value(QLatin1String("xml:lang")).toString();
+            text.offer(lang, xml.readElementText(), languages);
+        } else if (xml.name() == QLatin1String("vendor")) {
+            overrides.vendorName = xml.readElementText();
+        } else if (xml.name() == QLatin1String("vendor_url")) {
+            overrides.vendorUrl = xml.readElementText();
+        } else if (xml.name() == QLatin1String("icon_name")) {
+            overrides.iconName = xml.readElementText();
+        } else if (xml.name() == QLatin1String("defaults")) {
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("allow_any")) {
+                    implicitAny = implicitAuthorization(xml.readElementText());
+                } else if (xml.name() == QLatin1String("allow_inactive")) {
+                    implicitInactive = implicitAuthorization(xml.readElementText());
+                } else if (xml.name() == QLatin1String("allow_active")) {
+                    implicitActive = implicitAuthorization(xml.readElementText());
+                } else {
+                    xml.skipCurrentElement();
+                }
+            }
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+
+    if (!actionId.isEmpty()) {
+        builder->add(actionId, description.text, message.text, overrides.vendorName, overrides.vendorUrl,
+                     overrides.iconName, implicitAny, implicitInactive, implicitActive);
+    }
+}
+
+ActionDescription::List parsePolicyFile(const QString &fileName, const QStringList &languages)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(POLKITQT1_CORE) << "Cannot read" << fileName << file.errorString();
+        return ActionDescription::List();
+    }
+
+    ActionDescriptionListBuilder builder;
+    PolicyDefaults defaults;
+    QXmlStreamReader xml(&file);
+    if (xml.readNextStartElement() && xml.name() == QLatin1String("policyconfig")) {
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("vendor")) {
+                defaults.vendorName = xml.readElementText();
+            } else if (xml.name() == QLatin1String("vendor_url")) {
+                defaults.vendorUrl = xml.readElementText();
+            } else if (xml.name() == QLatin1String("icon_name")) {
+                defaults.iconName = xml.readElementText();
+            } else if (xml.name() == QLatin1String("action")) {
+                parseAction(xml, defaults, languages, &builder);
+            } else {
+                xml.skipCurrentElement();
+            }
+        }
+    }
+
+    // polkitd ignores the whole file then
+    if (xml.hasError()) {
+        qCWarning(POLKITQT1_CORE) << "Cannot parse" << fileName << xml.errorString();
+        return ActionDescription::List();
+    }
+    return builder.take();
+}
+
+class ParseJob : public QRunnable
+{
+public:
+    ParseJob(const QString &fileName, const QStringList &languages, ActionDescription::List *result)
+        : m_fileName(fileName)
+        , m_languages(languages)
+        , m_result(result)
+    {
+    }
+
+    void run() override
+    {
+        *m_result = parsePolicyFile(m_fileName, m_languages);
+    }
+
+private:
+    QString m_fileName;
+    QStringList m_languages;
+    ActionDescription::List *m_result;
+};
+
+}
+
+class Q_DECL_HIDDEN PolicyFileSource::Private
+{
+public:
+    struct File
+    {
+        File()
+            : size(-1)
+        {
+        }
+
+        QDateTime modified;
+        qint64 size;
+        ActionDescription::List actions;
+    };
+
+    Private(PolicyFileSource *parent, const QString &dir)
+        : q(parent)
+        , directory(dir)
+        , watcher(nullptr)
+        , localeChanged(false)
+    {
+        // Package managers install many files in a row
+        reloadTimer.setSingleShot(true);
+        reloadTimer.setInterval(200);
+    }
+
+    QStringList languages() const;
+    void merge();
+    void watchFiles();
+
+    PolicyFileSource *q;
+    QString directory;
+    QLocale locale;
+    QMap<QString, File> files;
+    // All actions of files, sorted
+    ActionDescription::List actions;
+    QFileSystemWatcher *watcher;
+    // The actions were dropped by setLocale(), the next load() changes them
+    bool localeChanged;
+    QTimer reloadTimer;
+    QThreadPool pool;
+};
+
+QStringList PolicyFileSource::Private::languages() const
+{
+    // Like polkitd: the translation for the exact locale, else the one for its language
+    QStringList result;
+    const QString name = locale.name();
+    if (name != QLatin1String("C")) {
+        result.append(name);
+        const int separator = name.indexOf(QLatin1Char('_'));
+        if (separator > 0) {
+            result.append(name.left(separator));
+        }
+    }
+    return result;
+}
+
+void PolicyFileSource::Private::merge()
+{
+    actions.clear();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        actions += it.value().actions;
+    }
+    std::sort(actions.begin(), actions.end(), [](const ActionDescription &a, const ActionDescription &b) {
+        return a.actionId() < b.actionId();
+    });
+}
+
+void PolicyFileSource::Private::watchFiles()
+{
+    // Replaced files have to be watched again
+    const QStringList watched = watcher->files();
+    if (!watched.isEmpty()) {
+        watcher->removePaths(watched);
+    }
+    if (!files.isEmpty()) {
+        watcher->addPaths(files.keys());
+    }
+}
+
+PolicyFileSource::PolicyFileSource(QObject *parent)
+        : PolicyFileSource(ActionSnapshot::actionDirectory(), parent)
+{
+}
+
+PolicyFileSource::PolicyFileSource(const QString &directory, QObject *parent)
+        : QObject(parent)
+        , d(new Private(this, directory))
+{
+    connect(&d->reloadTimer, &QTimer::timeout, this, [this]() {
+        if (load()) {
+            Q_EMIT changed();
+        }
+    });
+}
+
+PolicyFileSource::~PolicyFileSource()
+{
+    delete d;
+}
+
+QString PolicyFileSource::directory() const
+{
+    return d->directory;
+}
+
+void PolicyFileSource::setLocale(const QLocale &locale)
+{
+    if (locale != d->locale) {
+        d->locale = locale;
+        // Parsed for the old locale
+        d->files.clear();
+        d->actions.clear();
+        d->localeChanged = true;
+    }
+}
+
+QLocale PolicyFileSource::locale() const
+{
+    return d->locale;
+}
+
+bool PolicyFileSource::load()
+{
+    const QFileInfoList infos = QDir(d->directory).entryInfoList(QStringList() << QStringLiteral("*.policy"),
+                                                                 QDir::Files | QDir::Readable, QDir::Name);
+
+    bool changed = d->localeChanged;
+    d->localeChanged = false;
+    QMap<QString, Private::File> files;
+    QStringList toParse;
+    for (const QFileInfo &info : infos) {
+        const QString fileName = info.absoluteFilePath();
+        Private::File file = d->files.value(fileName);
+        if (file.modified != info.lastModified() || file.size != info.size()) {
+            file.modified = info.lastModified();
+            file.size = info.size();
+            toParse.append(fileName);
+        }
+        files.insert(fileName, file);
+    }
+    for (auto it = d->files.constBegin(); it != d->files.constEnd(); ++it) {
+        if (!files.contains(it.key())) {
+            changed = true;
+        }
+    }
+
+    // One job per file, each writing the result into its own slot
+    QVector<ActionDescription::List> results(toParse.size());
+    const QStringList languages = d->languages();
+    if (toParse.size() == 1) {
+        results[0] = parsePolicyFile(toParse.first(), languages);
+    } else {
+        for (int i = 0; i < toParse.size(); ++i) {
+            d->pool.start(new ParseJob(toParse.at(i), languages, &results[i]));
+        }
+        d->pool.waitForDone();
+    }
+
+    for (int i = 0; i < toParse.size(); ++i) {
+        ActionDescription::List &actions = files[toParse.at(i)].actions;
+        if (actions != results.at(i)) {
+            actions = results.at(i);
+            changed = true;
+        }
+    }
+
+    d->files.swap(files);
+    if (changed) {
+        d->merge();
+    }
+    if (d->watcher) {
+        d->watchFiles();
+    }
+    return changed;
+}
+
+void PolicyFileSource::setWatching(bool enabled)
+{
+    if (enabled == isWatching()) {
+        return;
+    }
+
+    if (enabled) {
+        d->watcher = new QFileSystemWatcher(this);
+        // Changes of the directory catch added, removed and replaced files, those of the files edits in place
+        d->watcher->addPath(d->directory);
+        d->watchFiles();
+        connect(d->watcher, &QFileSystemWatcher::directoryChanged, &d->reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+        connect(d->watcher, &QFileSystemWatcher::fileChanged, &d->reloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    } else {
+        delete d->watcher;
+        d->watcher = nullptr;
+        d->reloadTimer.stop();
+    }
+}
+
+bool PolicyFileSource::isWatching() const
+{
+    return d->watcher != nullptr;
+}
+
+ActionDescription::List PolicyFileSource::actions() const
+{
+    return d->actions;
+}
+
+}
+
+#include "moc_polkitqt1-policyfilesource.cpp"
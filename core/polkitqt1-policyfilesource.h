@@ -0,0 +1,113 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_POLICYFILESOURCE_H
+#define POLKITQT1_POLICYFILESOURCE_H
+
+#include "polkitqt1-core-export.h"
+#include "polkitqt1-actiondescription.h"
+
+#include <QLocale>
+#include <QObject>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class PolicyFileSource polkitqt1-policyfilesource.h PolicyFileSource
+ *
+ * \brief Reads the action descriptions from the .policy files
+ *
+ * Parses the .policy files polkitd reads its actions from directly, without
+ * asking polkitd. This gives the action descriptions when polkitd is slow or
+ * not running at all, in the same form as Authority::enumerateActionsSync().
+ *
+ * Descriptions and messages are translated to locale() the way polkitd
+ * translates them. The files are parsed in parallel, and after the first
+ * load() only the files that changed are parsed again. With setWatching()
+ * the directory is watched and changes are picked up on their own.
+ *
+ * \note polkitd may know actions that are not described by a .policy file,
+ *       and the implicit authorizations it reports take its configuration
+ *       into account, which this class does not know of.
+ *
+ * \since 0.201
+ */
+class POLKITQT1_CORE_EXPORT PolicyFileSource : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PolicyFileSource)
+public:
+    /**
+     * Reads the .policy files of the directory polkitd reads them from.
+     */
+    explicit PolicyFileSource(QObject *parent = nullptr);
+
+    /**
+     * Reads the .policy files of \p directory.
+     */
+    explicit PolicyFileSource(const QString &directory, QObject *parent = nullptr);
+    ~PolicyFileSource() override;
+
+    /**
+     * \return the directory the .policy files are read from
+     */
+    QString directory() const;
+
+    /**
+     * Sets the locale to translate descriptions and messages to, the default
+     * locale by default. actions() is empty until the next load(), which
+     * parses all files again and reports a change.
+     */
+    void setLocale(const QLocale &locale);
+
+    /**
+     * \return the locale descriptions and messages are translated to
+     */
+    QLocale locale() const;
+
+    /**
+     * Parses the .policy files that were added or modified since the last
+     * call, and forgets the actions of those that were removed. The first
+     * call parses all files.
+     *
+     * Files that cannot be parsed are skipped, like polkitd does.
+     *
+     * \return \c true if the actions changed
+     */
+    bool load();
+
+    /**
+     * Sets whether the directory is watched for changes. While watching,
+     * load() is called shortly after the .policy files changed and changed()
+     * is emitted if the actions changed. Disabled by default.
+     */
+    void setWatching(bool enabled);
+
+    /**
+     * \return \c true if the directory is watched for changes
+     */
+    bool isWatching() const;
+
+    /**
+     * \return the actions of all files loaded, sorted by action id
+     */
+    ActionDescription::List actions() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the watched .policy files changed the actions.
+     */
+    void changed();
+
+private:
+    class Private;
+    Private * const d;
+};
+
+}
+
+#endif
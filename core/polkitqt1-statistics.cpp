@@ -0,0 +1,151 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-statistics_p.h"
+#include "polkitqt1-debug_p.h"
+#include "polkitqt1-tracer.h"
+
+#include <QMetaEnum>
+
+#include <cmath>
+#include <cstring>
+
+namespace PolkitQt1
+{
+
+void Statistics::Timer::finish(Outcome outcome) const
+{
+    if (m_statistics == nullptr) {
+        return;
+    }
+
+    const qint64 latency = (m_statistics->m_clock.nsecsElapsed() - m_started) / 1000;
+    const char *name = QMetaEnum::fromType<Authority::Operation>().valueToKey(m_operation);
+    Tracer::endAsyncEvent("authority", name, m_traceId);
+
+    static const char *const outcomeNames[] = { "succeeded", "failed", "cancelled" };
+    qCDebug(POLKITQT1_CORE, "operation=%s outcome=%s elapsed_us=%lld", name, outcomeNames[outcome], latency);
+
+    if (m_record) {
+        m_statistics->record(m_operation, latency, outcome);
+    }
+}
+
+Statistics::Statistics()
+{
+    m_clock.start();
+    std::memset(m_counters, 0, sizeof(m_counters));
+}
+
+void Statistics::setEnabled(bool enabled)
+{
+    m_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool Statistics::isEnabled() const
+{
+    return m_enabled.loadAcquire() != 0;
+}
+
+Statistics::Timer Statistics::start(Authority::Operation operation)
+{
+    Timer timer;
+    const bool record = isEnabled();
+    const bool trace = Tracer::isEnabled();
+    if (!record && !trace && !POLKITQT1_CORE().isDebugEnabled()) {
+        return timer;
+    }
+
+    timer.m_statistics = this;
+    timer.m_record = record;
+    timer.m_operation = operation;
+    timer.m_started = m_clock.nsecsElapsed();
+    if (trace) {
+        // The names of the meta enum are static, as the tracer needs them
+        timer.m_traceId = Tracer::beginAsyncEvent("authority", QMetaEnum::fromType<Authority::Operation>().valueToKey(operation));
+    }
+
+    if (record) {
+        QMutexLocker locker(&m_mutex);
+        ++m_counters[operation].inFlight;
+    }
+    return timer;
+}
+
+void Statistics::record(Authority::Operation operation, qint64 latency, Outcome outcome)
+{
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && (qint64(1) << bucket) < latency) {
+        ++bucket;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    Counters &counters = m_counters[operation];
+    ++counters.calls;
+    if (outcome == Failed) {
+        ++counters.errors;
+    } else if (outcome == Cancelled) {
+        ++counters.cancellations;
+    }
+    --counters.inFlight;
+    counters.maxLatency = qMax(counters.maxLatency, latency);
+    ++counters.buckets[bucket];
+}
+
+qint64 Statistics::percentile(const Counters &counters, double fraction)
+{
+    if (counters.calls == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(fraction * counters.calls)));
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        const quint64 count = counters.buckets[bucket];
+        if (seen + count < rank) {
+            seen += count;
+            continue;
+        }
+
+        // Assume the latencies are spread evenly over the bucket
+        const qint64 lower = bucket == 0 ? 0 : qint64(1) << (bucket - 1);
+        const qint64 upper = qint64(1) << bucket;
+        const qint64 estimate = lower + qint64((upper - lower) * double(rank - seen) / count);
+        return qMin(estimate, counters.maxLatency);
+    }
+
+    return counters.maxLatency;
+}
+
+Authority::OperationStatistics Statistics::statistics(Authority::Operation operation) const
+{
+    QMutexLocker locker(&m_mutex);
+    const Counters &counters = m_counters[operation];
+
+    Authority::OperationStatistics result;
+    result.calls = counters.calls;
+    result.errors = counters.errors;
+    result.cancellations = counters.cancellations;
+    result.inFlight = counters.inFlight;
+    result.p50 = percentile(counters, 0.50);
+    result.p95 = percentile(counters, 0.95);
+    result.p99 = percentile(counters, 0.99);
+    result.maxLatency = counters.maxLatency;
+    return result;
+}
+
+void Statistics::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (Counters &counters : m_counters) {
+        // Calls still running are not forgotten
+        const int inFlight = counters.inFlight;
+        std::memset(&counters, 0, sizeof(counters));
+        counters.inFlight = inFlight;
+    }
+}
+
+}
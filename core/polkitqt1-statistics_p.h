@@ -0,0 +1,108 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_STATISTICS_P_H
+#define POLKITQT1_STATISTICS_P_H
+
+#include "polkitqt1-authority.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+
+namespace PolkitQt1
+{
+
+/**
+ * \internal
+ * \brief Call counters and latency histograms of the operations of Authority
+ *
+ * Latencies are sorted into buckets of powers of two microseconds, so
+ * recording a call takes constant time and memory. While disabled, start()
+ * only checks whether debug output of the core category or the Tracer is
+ * enabled, which also get every call reported.
+ */
+class Q_DECL_HIDDEN Statistics
+{
+public:
+    enum Outcome {
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    /**
+     * Measures one call, from start() until finish() is called. A default
+     * constructed timer, as handed out while disabled, records nothing.
+     */
+    class Timer
+    {
+    public:
+        Timer()
+            : m_statistics(nullptr)
+            , m_record(false)
+            , m_operation(Authority::CheckAuthorizationOperation)
+            , m_started(0)
+            , m_traceId(0)
+        {
+        }
+
+        /**
+         * Records the call with \p outcome. Call this once per timer.
+         */
+        void finish(Outcome outcome) const;
+
+    private:
+        friend class Statistics;
+
+        Statistics *m_statistics;
+        // Whether statistics were enabled when the call started, otherwise it is only logged
+        bool m_record;
+        Authority::Operation m_operation;
+        qint64 m_started;
+        quint64 m_traceId;
+    };
+
+    Statistics();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * Starts measuring a call of \p operation.
+     */
+    Timer start(Authority::Operation operation);
+
+    Authority::OperationStatistics statistics(Authority::Operation operation) const;
+    void reset();
+
+private:
+    // 2^31 microseconds is more than half an hour, anything longer shares the last bucket
+    static const int BucketCount = 32;
+    static const int OperationCount = Authority::RevokeTemporaryAuthorizationOperation + 1;
+
+    struct Counters
+    {
+        quint64 calls;
+        quint64 errors;
+        quint64 cancellations;
+        int inFlight;
+        qint64 maxLatency;
+        quint64 buckets[BucketCount];
+    };
+
+    void record(Authority::Operation operation, qint64 latency, Outcome outcome);
+    static qint64 percentile(const Counters &counters, double fraction);
+
+    QAtomicInt m_enabled;
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    Counters m_counters[OperationCount];
+};
+
+}
+
+#endif
@@ -8,8 +8,8 @@
 #include "polkitqt1-subject.h"
 #include "polkitqt1-identity.h"
 #include "polkitqt1-config.h"
+#include "polkitqt1-debug_p.h"
 
-#include <QDebug>
 #include <polkit/polkit.h>
 
 namespace PolkitQt1
@@ -85,7 +85,10 @@ void Subject::setSubject(PolkitSubject *subject)
 QString Subject::toString() const
 {
     Q_ASSERT(d->subject);
-    return QString::fromUtf8(polkit_subject_to_string(d->subject));
+    gchar *string = polkit_subject_to_string(d->subject);
+    const QString result = QString::fromUtf8(string);
+    g_free(string);
+    return result;
 }
 
 Subject Subject::fromString(const QString &string)
@@ -94,7 +97,7 @@ Subject Subject::fromString(const QString &string)
     GError *error = nullptr;
     subject.d->subject = polkit_subject_from_string(string.toUtf8().data(), &error);
     if (error != nullptr) {
-        qWarning() << QString("Cannot create Subject from string: %1").arg(error->message);
+        qCWarning(POLKITQT1_CORE) << "Cannot create Subject from string:" << error->message;
         return {};
     }
     return subject;
@@ -171,7 +174,7 @@ UnixUserIdentity SystemBusNameSubject::user()
 #if HAVE_POLKIT_SYSTEM_BUS_NAME_GET_USER_SYNC
     return UnixUserIdentity(polkit_system_bus_name_get_user_sync((PolkitSystemBusName *) subject(), nullptr, nullptr));
 #else
-    qWarning("Polkit is too old, returning invalid user from SystemBusNameSubject::user()!");
+    qCWarning(POLKITQT1_CORE, "Polkit is too old, returning invalid user from SystemBusNameSubject::user()!");
     return UnixUserIdentity();
 #endif
 }
@@ -189,7 +192,7 @@ UnixSessionSubject::UnixSessionSubject(qint64 pid)
     GError *error = nullptr;
     setSubject(polkit_unix_session_new_for_process_sync(pid, nullptr, &error));
     if (error != nullptr) {
-        qWarning() << QString("Cannot create unix session: %1").arg(error->message);
+        qCWarning(POLKITQT1_CORE) << "Cannot create unix session:" << error->message;
         setSubject(nullptr);
     }
 }
@@ -0,0 +1,362 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "polkitqt1-tracer.h"
+#include "polkitqt1-debug_p.h"
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+
+namespace PolkitQt1
+{
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    char phase;
+    quint64 id;
+    qint64 timestamp;
+};
+
+/**
+ * Events of one thread. Only that thread appends to it, readers see every
+ * event published by the release store of its chunk's count.
+ *
+ * Once the buffer holds its limit of chunks, the oldest one is reused for
+ * the next events. That happens under the lock readers hold, so they never
+ * see a chunk being reused.
+ */
+class ThreadBuffer
+{
+public:
+    static const int ChunkSize = 1024;
+
+    struct Chunk
+    {
+        Chunk() : count(0), next(nullptr) {}
+
+        TraceEvent events[ChunkSize];
+        QAtomicInt count;
+        QAtomicPointer<Chunk> next;
+    };
+
+    ThreadBuffer(int tid, const QByteArray &threadName)
+        : tid(tid)
+        , threadName(threadName)
+        , first(new Chunk)
+        , last(first)
+        , chunkCount(1)
+    {
+    }
+
+    ~ThreadBuffer()
+    {
+        Chunk *chunk = first;
+        while (chunk != nullptr) {
+            Chunk *next = chunk->next.loadAcquire();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    void append(const TraceEvent &event, int maxChunks)
+    {
+        int index = last->count.loadAcquire();
+        if (index == ChunkSize) {
+            if (chunkCount < maxChunks) {
+                Chunk *chunk = new Chunk;
+                last->next.storeRelease(chunk);
+                last = chunk;
+                ++chunkCount;
+            } else {
+                dropOldest(maxChunks);
+            }
+            index = 0;
+        }
+        last->events[index] = event;
+        last->count.storeRelease(index + 1);
+    }
+
+    const int tid;
+    const QByteArray threadName;
+    // Held by readers, and by the owning thread while it reuses a chunk
+    QMutex mutex;
+    // Protected by mutex
+    Chunk *first;
+
+private:
+    /**
+     * Moves the oldest chunk behind the last one to take the next events,
+     * after freeing the chunks beyond \p maxChunks.
+     */
+    void dropOldest(int maxChunks)
+    {
+        QMutexLocker locker(&mutex);
+        // The limit may have been lowered
+        while (chunkCount > maxChunks && first != last) {
+            Chunk *chunk = first;
+            first = chunk->next.loadAcquire();
+            delete chunk;
+            --chunkCount;
+        }
+
+        Chunk *chunk = first;
+        chunk->count.storeRelease(0);
+        if (chunk != last) {
+            first = chunk->next.loadAcquire();
+            chunk->next.storeRelease(nullptr);
+            last->next.storeRelease(chunk);
+            last = chunk;
+        }
+    }
+
+    // Only used by the thread owning the buffer
+    Chunk *last;
+    int chunkCount;
+};
+
+void appendString(QByteArray &json, const char *string)
+{
+    json += '"';
+    for (const char *c = string; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            json += '\\';
+        }
+        if (uchar(*c) >= 0x20) {
+            json += *c;
+        }
+    }
+    json += '"';
+}
+
+const int s_defaultEventLimit = 65536;
+
+class TraceRegistry
+{
+public:
+    TraceRegistry()
+        : fileName(qgetenv("POLKIT_QT_TRACE_FILE"))
+        , maxChunks(s_defaultEventLimit / ThreadBuffer::ChunkSize)
+    {
+        clock.start();
+        if (!fileName.isEmpty()) {
+            enabled.storeRelease(1);
+        }
+    }
+
+    ~TraceRegistry()
+    {
+        if (!fileName.isEmpty() && !writeJson(QFile::decodeName(fileName))) {
+            qCWarning(POLKITQT1_CORE) << "Cannot write trace to" << fileName;
+        }
+        qDeleteAll(buffers);
+    }
+
+    ThreadBuffer *registerThread();
+    QByteArray toJson();
+    bool writeJson(const QString &fileName);
+
+    const QByteArray fileName;
+    QAtomicInt enabled;
+    // Per thread, see Tracer::setThreadEventLimit()
+    QAtomicInt maxChunks;
+    QAtomicInt lastId;
+    QElapsedTimer clock;
+    // Protects the list, not the buffers in it
+    QMutex mutex;
+    QList<ThreadBuffer *> buffers;
+};
+
+ThreadBuffer *TraceRegistry::registerThread()
+{
+    QThread *thread = QThread::currentThread();
+    QByteArray threadName = thread->objectName().toUtf8();
+    if (threadName.isEmpty()) {
+        threadName = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()
+                     ? QByteArrayLiteral("main") : QByteArrayLiteral("thread");
+    }
+
+    QMutexLocker locker(&mutex);
+    auto buffer = new ThreadBuffer(buffers.size() + 1, threadName);
+    buffers.append(buffer);
+    return buffer;
+}
+
+QByteArray TraceRegistry::toJson()
+{
+    QList<ThreadBuffer *> threads;
+    {
+        QMutexLocker locker(&mutex);
+        threads = buffers;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    for (ThreadBuffer *buffer : threads) {
+        const QByteArray tid = QByteArray::number(buffer->tid);
+
+        if (!first) {
+            json += ',';
+        }
+        first = false;
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":";
+        appendString(json, buffer->threadName.constData());
+        json += "}}";
+
+        QMutexLocker bufferLocker(&buffer->mutex);
+        for (ThreadBuffer::Chunk *chunk = buffer->first; chunk != nullptr; chunk = chunk->next.loadAcquire()) {
+            const int count = chunk->count.loadAcquire();
+            for (int i = 0; i < count; ++i) {
+                const TraceEvent &event = chunk->events[i];
+                json += ",{\"name\":";
+                appendString(json, event.name);
+                json += ",\"cat\":";
+                appendString(json, event.category);
+                json += ",\"ph\":\"";
+                json += event.phase;
+                json += "\",\"ts\":" + QByteArray::number(event.timestamp / 1000.0, 'f', 3);
+                json += ",\"pid\":" + pid + ",\"tid\":" + tid;
+                if (event.id != 0) {
+                    json += ",\"id\":" + QByteArray::number(event.id);
+                }
+                if (event.phase == 'i') {
+                    json += ",\"s\":\"t\"";
+                }
+                json += '}';
+            }
+        }
+    }
+    json += "]}";
+
+    return json;
+}
+
+bool TraceRegistry::writeJson(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    const QByteArray json = toJson();
+    return file.write(json) == json.size();
+}
+
+Q_GLOBAL_STATIC(TraceRegistry, s_registry)
+
+// Buffers are owned by the registry, they outlive their threads
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+// Applies POLKIT_QT_TRACE_FILE as soon as the library is loaded
+const bool s_registryCreated = s_registry() != nullptr;
+
+void record(const char *category, const char *name, char phase, quint64 id = 0)
+{
+    TraceRegistry *registry = s_registry();
+    if (registry == nullptr) {
+        return;
+    }
+    if (t_buffer == nullptr) {
+        t_buffer = registry->registerThread();
+    }
+    t_buffer->append(TraceEvent{category, name, phase, id, registry->clock.nsecsElapsed()},
+                     registry->maxChunks.loadAcquire());
+}
+
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    if (TraceRegistry *registry = s_registry()) {
+        registry->enabled.storeRelease(enabled ? 1 : 0);
+    }
+}
+
+bool Tracer::isEnabled()
+{
+    TraceRegistry *registry = s_registry();
+    return registry != nullptr && registry->enabled.loadAcquire() != 0;
+}
+
+void Tracer::beginEvent(const char *category, const char *name)
+{
+    if (isEnabled()) {
+        record(category, name, 'B');
+    }
+}
+
+void Tracer::endEvent(const char *category, const char *name)
+{
+    if (isEnabled()) {
+        record(category, name, 'E');
+    }
+}
+
+void Tracer::setThreadEventLimit(int events)
+{
+    if (TraceRegistry *registry = s_registry()) {
+        // Whole chunks, at least one
+        registry->maxChunks.storeRelease(qMax(1, (events + ThreadBuffer::ChunkSize - 1) / ThreadBuffer::ChunkSize));
+    }
+}
+
+int Tracer::threadEventLimit()
+{
+    TraceRegistry *registry = s_registry();
+    return (registry != nullptr ? registry->maxChunks.loadAcquire() : s_defaultEventLimit / ThreadBuffer::ChunkSize)
+           * ThreadBuffer::ChunkSize;
+}
+
+quint64 Tracer::beginAsyncEvent(const char *category, const char *name)
+{
+    if (!isEnabled()) {
+        return 0;
+    }
+
+    const quint64 id = quint64(s_registry()->lastId.fetchAndAddRelaxed(1)) + 1;
+    record(category, name, 'b', id);
+    return id;
+}
+
+void Tracer::endAsyncEvent(const char *category, const char *name, quint64 id)
+{
+    // Spans that started are always ended, even if tracing was disabled meanwhile
+    if (id != 0) {
+        record(category, name, 'e', id);
+    }
+}
+
+void Tracer::instantEvent(const char *category, const char *name)
+{
+    if (isEnabled()) {
+        record(category, name, 'i');
+    }
+}
+
+QByteArray Tracer::toJson()
+{
+    TraceRegistry *registry = s_registry();
+    return registry != nullptr ? registry->toJson() : QByteArray();
+}
+
+bool Tracer::writeJson(const QString &fileName)
+{
+    TraceRegistry *registry = s_registry();
+    return registry != nullptr && registry->writeJson(fileName);
+}
+
+}
@@ -0,0 +1,120 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_TRACER_H
+#define POLKITQT1_TRACER_H
+
+#include "polkitqt1-core-export.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace PolkitQt1
+{
+
+/**
+ * \class Tracer polkitqt1-tracer.h Tracer
+ *
+ * \brief Records authorization activity as Chrome trace events
+ *
+ * While enabled, polkit-qt records the calls made by Authority, the
+ * authorization checks of Gui::Action, the authentications handled by an
+ * agent and the change notifications. They can be saved in the Chrome trace
+ * event format, to be opened in chrome://tracing or Perfetto next to the
+ * traces of the application itself.
+ *
+ * Every thread records into a buffer of its own without taking any lock, so
+ * tracing barely affects the timing it records. Each buffer keeps the latest
+ * 65536 events of its thread, older ones are dropped, see
+ * setThreadEventLimit().
+ *
+ * Setting the environment variable \c POLKIT_QT_TRACE_FILE to a file name
+ * enables tracing when the library is loaded and writes the trace to that
+ * file when the process exits.
+ *
+ * Applications can add events of their own. Names and categories are not
+ * copied and have to stay valid until the process exits, so pass string
+ * literals.
+ *
+ * \since 0.201
+ */
+class POLKITQT1_CORE_EXPORT Tracer
+{
+public:
+    /**
+     * Enables or disables recording. Tracing is disabled by default, and
+     * costs next to nothing then.
+     *
+     * \param enabled \c true to record events
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * \return \c true if events are recorded
+     */
+    static bool isEnabled();
+
+    /**
+     * Sets how many events every thread keeps at most, 65536 by default. Once
+     * a thread recorded more, its oldest events are dropped 1024 at a time to
+     * make room, so a long running process does not grow without bound. The
+     * limit is rounded up to a multiple of 1024.
+     */
+    static void setThreadEventLimit(int events);
+
+    /**
+     * \return the number of events every thread keeps at most
+     */
+    static int threadEventLimit();
+
+    /**
+     * Starts a span in the calling thread, ended by endEvent() in the same thread.
+     */
+    static void beginEvent(const char *category, const char *name);
+
+    /**
+     * Ends the last span started by beginEvent() in the calling thread.
+     */
+    static void endEvent(const char *category, const char *name);
+
+    /**
+     * Starts a span that may end in another thread or interleave with other
+     * spans, like an asynchronous call.
+     *
+     * \return the id to pass to endAsyncEvent(), \c 0 if tracing is disabled
+     */
+    static quint64 beginAsyncEvent(const char *category, const char *name);
+
+    /**
+     * Ends the span started by beginAsyncEvent() that returned \p id. Does
+     * nothing if \p id is \c 0.
+     */
+    static void endAsyncEvent(const char *category, const char *name, quint64 id);
+
+    /**
+     * Records an event without duration, e.g. a notification.
+     */
+    static void instantEvent(const char *category, const char *name);
+
+    /**
+     * \return all events recorded so far as a Chrome trace event JSON document
+     */
+    static QByteArray toJson();
+
+    /**
+     * Writes toJson() to \p fileName.
+     *
+     * \return \c true if the file was written
+     */
+    static bool writeJson(const QString &fileName);
+
+private:
+    Tracer();
+};
+
+}
+
+#endif
@@ -8,10 +8,13 @@
 */
 
 #include "polkitqt1-gui-action.h"
+#include "polkitqt1-gui-debug_p.h"
 #include "polkitqt1-authority.h"
 #include "polkitqt1-subject.h"
+#include "polkitqt1-tracer.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 namespace PolkitQt1
 {
@@ -214,7 +217,15 @@ bool Action::Private::computePkResult()
     old_result = pkResult;
     pkResult = Authority::Unknown;
 
+    QElapsedTimer elapsed;
+    if (POLKITQT1_GUI().isDebugEnabled()) {
+        elapsed.start();
+    }
+    Tracer::beginEvent("gui", "computePkResult");
     pkResult = Authority::instance()->checkAuthorizationSync(actionId, subject, Authority::None);
+    Tracer::endEvent("gui", "computePkResult");
+    qCDebug(POLKITQT1_GUI, "computePkResult action=%s result=%d elapsed_us=%lld",
+            qPrintable(actionId), int(pkResult), elapsed.isValid() ? elapsed.nsecsElapsed() / 1000 : qint64(-1));
 
     return old_result != pkResult;
 }
@@ -0,0 +1,14 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef POLKITQT1_GUI_DEBUG_P_H
+#define POLKITQT1_GUI_DEBUG_P_H
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(POLKITQT1_GUI)
+
+#endif
@@ -1 +1,3 @@
 #cmakedefine01 HAVE_POLKIT_SYSTEM_BUS_NAME_GET_USER_SYNC
+#cmakedefine01 USE_QTDBUS_BACKEND
+#define POLKIT_ACTIONS_DIR "@POLKIT_ACTIONS_DIR@"
@@ -0,0 +1,486 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// Load generator for polkitd and for the overhead of the library itself.
+// Runs a weighted mix of operations at a given concurrency and rate and
+// prints the throughput, latency percentiles and error rate of each of them
+// as JSON, together with the statistics Authority collected meanwhile:
+//
+//   polkitqt1-bench --mix check-async=8,check-sync=1,enumerate-async=1 \
+//                   --concurrency 16 --rate 500 --duration 10
+//
+// By default this talks to polkitd on the system bus and needs the file
+// org.qt.policykit.examples.policy from examples to be installed. --address
+// uses another bus, --fake a FakeAuthority on a private bus.
+
+#include "fakeauthority.h"
+
+#include <polkitqt1-authority.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace PolkitQt1;
+
+enum Kind {
+    CheckSync,
+    CheckAsync,
+    EnumerateSync,
+    EnumerateAsync,
+    TemporarySync,
+    TemporaryAsync,
+    KindCount
+};
+
+static const char *const s_kindNames[KindCount] = {
+    "check-sync", "check-async", "enumerate-sync", "enumerate-async", "temporary-sync", "temporary-async"
+};
+
+struct Options
+{
+    QString actionId;
+    int concurrency;
+    // Operations per second, 0 for as fast as possible
+    double rate;
+    // Run time in milliseconds, 0 to stop after a number of requests
+    qint64 duration;
+    qint64 requests;
+    QVector<int> weights;
+};
+
+class Bench : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Bench(const Options &options, QObject *parent = nullptr);
+
+    QJsonObject report() const;
+
+public Q_SLOTS:
+    void start();
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void pump();
+    void syncFinished(int kind, qint64 started, bool failed);
+
+private:
+    Kind pickKind();
+    void startOperation(Kind kind);
+    void operationFinished(Kind kind, qint64 started, bool failed);
+
+    const Options m_options;
+    const UnixProcessSubject m_subject;
+    std::mt19937 m_random;
+    std::discrete_distribution<int> m_mix;
+    QElapsedTimer m_clock;
+    QTimer m_rateTimer;
+    qint64 m_elapsed;
+    qint64 m_startedCount;
+    int m_inFlight;
+    bool m_stopping;
+    QVector<qint64> m_latencies[KindCount];
+    quint64 m_errors[KindCount];
+};
+
+/**
+ * Runs one synchronous operation in the thread pool, so that many of them
+ * can block at the same time.
+ */
+class SyncOperation : public QRunnable
+{
+public:
+    SyncOperation(Bench *bench, Kind kind, const QString &actionId, const Subject &subject, qint64 started)
+        : m_bench(bench)
+        , m_kind(kind)
+        , m_actionId(actionId)
+        , m_subject(subject)
+        , m_started(started)
+    {
+    }
+
+    void run() override
+    {
+        Authority *authority = Authority::instance();
+        bool failed = false;
+        switch (m_kind) {
+        case CheckSync:
+            failed = authority->checkAuthorizationResultSync(m_actionId, m_subject, Authority::None).isError();
+            break;
+        case EnumerateSync:
+            authority->enumerateActionsSync();
+            failed = authority->hasError();
+            break;
+        case TemporarySync:
+            authority->enumerateTemporaryAuthorizationsSync(m_subject);
+            failed = authority->hasError();
+            break;
+        default:
+            break;
+        }
+        // The error state is per thread, don't let it block the next operation
+        authority->clearError();
+
+        QMetaObject::invokeMethod(m_bench, "syncFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, m_kind), Q_ARG(qint64, m_started), Q_ARG(bool, failed));
+    }
+
+private:
+    Bench *m_bench;
+    Kind m_kind;
+    QString m_actionId;
+    Subject m_subject;
+    qint64 m_started;
+};
+
+Bench::Bench(const Options &options, QObject *parent)
+        : QObject(parent)
+        , m_options(options)
+        , m_subject(QCoreApplication::applicationPid())
+        // Fixed seed, so runs with the same options issue the same operations
+        , m_random(42)
+        , m_mix(options.weights.constBegin(), options.weights.constEnd())
+        , m_elapsed(0)
+        , m_startedCount(0)
+        , m_inFlight(0)
+        , m_stopping(false)
+{
+    std::fill(m_errors, m_errors + KindCount, 0);
+    m_rateTimer.setSingleShot(true);
+    connect(&m_rateTimer, &QTimer::timeout, this, &Bench::pump);
+}
+
+void Bench::start()
+{
+    m_clock.start();
+    pump();
+}
+
+Kind Bench::pickKind()
+{
+    return Kind(m_mix(m_random));
+}
+
+void Bench::pump()
+{
+    while (!m_stopping && m_inFlight < m_options.concurrency) {
+        const qint64 now = m_clock.nsecsElapsed();
+        if ((m_options.duration > 0 && now >= m_options.duration * 1000000)
+                || (m_options.requests > 0 && m_startedCount >= m_options.requests)) {
+            m_stopping = true;
+            break;
+        }
+
+        if (m_options.rate > 0) {
+            const qint64 due = qint64(m_startedCount * 1e9 / m_options.rate);
+            if (due > now) {
+                m_rateTimer.start(int(qMax<qint64>(1, (due - now) / 1000000)));
+                return;
+            }
+        }
+
+        startOperation(pickKind());
+    }
+
+    if (m_stopping && m_inFlight == 0) {
+        m_elapsed = m_clock.nsecsElapsed();
+        Q_EMIT finished();
+    }
+}
+
+void Bench::startOperation(Kind kind)
+{
+    Authority *authority = Authority::instance();
+    const qint64 started = m_clock.nsecsElapsed();
+    ++m_startedCount;
+    ++m_inFlight;
+
+    switch (kind) {
+    case CheckAsync: {
+        auto watcher = new QFutureWatcher<Authority::CheckResult>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, started]() {
+            operationFinished(CheckAsync, started, watcher->result().isError());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(authority->checkAuthorizationResultAsync(m_options.actionId, m_subject, Authority::None));
+        break;
+    }
+    case EnumerateAsync: {
+        auto watcher = new QFutureWatcher<ActionDescription::List>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, started, authority]() {
+            // Asynchronous calls fail in the error state of this thread
+            const bool failed = authority->hasError();
+            authority->clearError();
+            operationFinished(EnumerateAsync, started, failed);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(authority->enumerateActionsAsync());
+        break;
+    }
+    case TemporaryAsync: {
+        auto watcher = new QFutureWatcher<TemporaryAuthorization::List>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, started, authority]() {
+            const bool failed = authority->hasError();
+            authority->clearError();
+            operationFinished(TemporaryAsync, started, failed);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(authority->enumerateTemporaryAuthorizationsAsync(m_subject));
+        break;
+    }
+    default:
+        QThreadPool::globalInstance()->start(new SyncOperation(this, kind, m_options.actionId, m_subject, started));
+        break;
+    }
+}
+
+void Bench::syncFinished(int kind, qint64 started, bool failed)
+{
+    operationFinished(Kind(kind), started, failed);
+}
+
+void Bench::operationFinished(Kind kind, qint64 started, bool failed)
+{
+    m_latencies[kind].append((m_clock.nsecsElapsed() - started) / 1000);
+    if (failed) {
+        ++m_errors[kind];
+    }
+    --m_inFlight;
+    pump();
+}
+
+static QJsonObject latencyReport(QVector<qint64> latencies)
+{
+    QJsonObject report;
+    if (latencies.isEmpty()) {
+        return report;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    qint64 sum = 0;
+    for (qint64 latency : latencies) {
+        sum += latency;
+    }
+
+    // Nearest rank
+    auto percentile = [&latencies](double fraction) {
+        const int rank = qMax(1, int(std::ceil(fraction * latencies.size())));
+        return double(latencies.at(rank - 1));
+    };
+    report.insert(QStringLiteral("min"), double(latencies.first()));
+    report.insert(QStringLiteral("mean"), double(sum) / latencies.size());
+    report.insert(QStringLiteral("p50"), percentile(0.50));
+    report.insert(QStringLiteral("p90"), percentile(0.90));
+    report.insert(QStringLiteral("p95"), percentile(0.95));
+    report.insert(QStringLiteral("p99"), percentile(0.99));
+    report.insert(QStringLiteral("max"), double(latencies.last()));
+    return report;
+}
+
+QJsonObject Bench::report() const
+{
+    const double seconds = m_elapsed / 1e9;
+    QJsonObject operations;
+    quint64 totalCount = 0;
+    quint64 totalErrors = 0;
+
+    for (int kind = 0; kind < KindCount; ++kind) {
+        const quint64 count = m_latencies[kind].size();
+        if (count == 0) {
+            continue;
+        }
+        totalCount += count;
+        totalErrors += m_errors[kind];
+
+        QJsonObject operation;
+        operation.insert(QStringLiteral("count"), double(count));
+        operation.insert(QStringLiteral("errors"), double(m_errors[kind]));
+        operation.insert(QStringLiteral("error_rate"), double(m_errors[kind]) / count);
+        operation.insert(QStringLiteral("throughput"), seconds > 0 ? count / seconds : 0.0);
+        operation.insert(QStringLiteral("latency_us"), latencyReport(m_latencies[kind]));
+        operations.insert(QLatin1String(s_kindNames[kind]), operation);
+    }
+
+    QJsonObject total;
+    total.insert(QStringLiteral("count"), double(totalCount));
+    total.insert(QStringLiteral("errors"), double(totalErrors));
+    total.insert(QStringLiteral("error_rate"), totalCount > 0 ? double(totalErrors) / totalCount : 0.0);
+    total.insert(QStringLiteral("throughput"), seconds > 0 ? totalCount / seconds : 0.0);
+
+    // What the library measured, from the start of each call to its result
+    QJsonObject library;
+    const QMetaEnum operationEnum = QMetaEnum::fromType<Authority::Operation>();
+    for (int i = 0; i < operationEnum.keyCount(); ++i) {
+        const auto operation = Authority::Operation(operationEnum.value(i));
+        const Authority::OperationStatistics statistics = Authority::instance()->statistics(operation);
+        if (statistics.calls == 0) {
+            continue;
+        }
+
+        QJsonObject entry;
+        entry.insert(QStringLiteral("calls"), double(statistics.calls));
+        entry.insert(QStringLiteral("errors"), double(statistics.errors));
+        entry.insert(QStringLiteral("cancellations"), double(statistics.cancellations));
+        entry.insert(QStringLiteral("p50_us"), double(statistics.p50));
+        entry.insert(QStringLiteral("p95_us"), double(statistics.p95));
+        entry.insert(QStringLiteral("p99_us"), double(statistics.p99));
+        entry.insert(QStringLiteral("max_us"), double(statistics.maxLatency));
+        library.insert(QLatin1String(operationEnum.key(i)), entry);
+    }
+
+    QJsonObject mix;
+    for (int kind = 0; kind < KindCount; ++kind) {
+        if (m_options.weights.at(kind) > 0) {
+            mix.insert(QLatin1String(s_kindNames[kind]), m_options.weights.at(kind));
+        }
+    }
+    QJsonObject configuration;
+    configuration.insert(QStringLiteral("action"), m_options.actionId);
+    configuration.insert(QStringLiteral("concurrency"), m_options.concurrency);
+    configuration.insert(QStringLiteral("rate"), m_options.rate);
+    configuration.insert(QStringLiteral("duration_ms"), double(m_options.duration));
+    configuration.insert(QStringLiteral("requests"), double(m_options.requests));
+    configuration.insert(QStringLiteral("mix"), mix);
+
+    QJsonObject report;
+    report.insert(QStringLiteral("configuration"), configuration);
+    report.insert(QStringLiteral("elapsed_s"), seconds);
+    report.insert(QStringLiteral("total"), total);
+    report.insert(QStringLiteral("operations"), operations);
+    report.insert(QStringLiteral("library"), library);
+    return report;
+}
+
+static bool parseMix(const QString &spec, QVector<int> *weights)
+{
+    weights->fill(0, KindCount);
+    for (const QString &entry : spec.split(QLatin1Char(','))) {
+        if (entry.trimmed().isEmpty()) {
+            continue;
+        }
+        const int separator = entry.indexOf(QLatin1Char('='));
+        const QString name = entry.left(separator).trimmed();
+        bool ok = true;
+        const int weight = separator < 0 ? 1 : entry.mid(separator + 1).toInt(&ok);
+        const char *const *kind = std::find_if(s_kindNames, s_kindNames + KindCount, [&name](const char *kindName) {
+            return name == QLatin1String(kindName);
+        });
+        if (!ok || weight < 0 || kind == s_kindNames + KindCount) {
+            return false;
+        }
+        (*weights)[kind - s_kindNames] = weight;
+    }
+    return std::any_of(weights->constBegin(), weights->constEnd(), [](int weight) {
+        return weight > 0;
+    });
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Drives a mix of polkit operations and reports their performance as JSON"));
+    parser.addHelpOption();
+    const QCommandLineOption mixOption(QStringLiteral("mix"),
+        QStringLiteral("Comma separated operation=weight pairs, operations are check-sync, check-async, "
+                       "enumerate-sync, enumerate-async, temporary-sync and temporary-async."),
+        QStringLiteral("mix"), QStringLiteral("check-async"));
+    const QCommandLineOption concurrencyOption(QStringLiteral("concurrency"),
+        QStringLiteral("Operations in flight at the same time."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"),
+        QStringLiteral("Operations started per second, 0 for as many as possible."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+        QStringLiteral("Seconds to run, unless --requests is given."), QStringLiteral("seconds"), QStringLiteral("10"));
+    const QCommandLineOption requestsOption(QStringLiteral("requests"),
+        QStringLiteral("Number of operations to run instead of a duration."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption actionOption(QStringLiteral("action"),
+        QStringLiteral("Action to check."), QStringLiteral("id"), QStringLiteral("org.qt.policykit.examples.cry"));
+    const QCommandLineOption addressOption(QStringLiteral("address"),
+        QStringLiteral("Address of the bus polkitd runs on, instead of the system bus."), QStringLiteral("address"));
+    const QCommandLineOption fakeOption(QStringLiteral("fake"),
+        QStringLiteral("Run against a fake polkitd on a private bus, to measure the library alone."));
+    const QCommandLineOption fakeLatencyOption(QStringLiteral("fake-latency"),
+        QStringLiteral("Milliseconds the fake polkitd delays each reply."), QStringLiteral("msec"), QStringLiteral("0"));
+    const QCommandLineOption workerThreadOption(QStringLiteral("worker-thread"),
+        QStringLiteral("Let Authority run its calls in its worker thread."));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QStringLiteral("File to write the report to instead of stdout."), QStringLiteral("file"));
+    parser.addOptions({ mixOption, concurrencyOption, rateOption, durationOption, requestsOption, actionOption,
+                        addressOption, fakeOption, fakeLatencyOption, workerThreadOption, outputOption });
+    parser.process(app);
+
+    Options options;
+    options.actionId = parser.value(actionOption);
+    options.concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    options.rate = qMax(0.0, parser.value(rateOption).toDouble());
+    options.requests = qMax<qint64>(0, parser.value(requestsOption).toLongLong());
+    options.duration = options.requests > 0 ? 0 : qint64(parser.value(durationOption).toDouble() * 1000);
+    if (!parseMix(parser.value(mixOption), &options.weights)) {
+        std::fprintf(stderr, "Invalid operation mix: %s\n", qPrintable(parser.value(mixOption)));
+        return 1;
+    }
+
+    FakePolkit fake;
+    if (parser.isSet(fakeOption)) {
+        if (!fake.start()) {
+            std::fprintf(stderr, "Cannot start the fake polkitd\n");
+            return 1;
+        }
+        fake.authority()->setRule(options.actionId, Authority::Yes);
+        fake.authority()->setLatency(parser.value(fakeLatencyOption).toInt());
+    } else if (parser.isSet(addressOption)) {
+        // Has to be set before the first Authority::instance()
+        qputenv("DBUS_SYSTEM_BUS_ADDRESS", parser.value(addressOption).toUtf8());
+    }
+
+    Authority *authority = Authority::instance();
+    if (authority->hasError()) {
+        std::fprintf(stderr, "Cannot reach polkitd: %s\n", qPrintable(authority->errorDetails()));
+        return 1;
+    }
+    authority->setStatisticsEnabled(true);
+    authority->setWorkerThreadEnabled(parser.isSet(workerThreadOption));
+    // Enough threads for every synchronous operation to block at the same time
+    QThreadPool::globalInstance()->setMaxThreadCount(qMax(options.concurrency, QThreadPool::globalInstance()->maxThreadCount()));
+
+    Bench bench(options);
+    QObject::connect(&bench, &Bench::finished, &app, &QCoreApplication::quit);
+    QTimer::singleShot(0, &bench, &Bench::start);
+    app.exec();
+
+    const QByteArray json = QJsonDocument(bench.report()).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+    }
+
+    return 0;
+}
+
+#include "bench.moc"
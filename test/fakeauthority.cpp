@@ -0,0 +1,523 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "fakeauthority.h"
+
+#include <polkitqt1-actiondescription.h>
+
+#include <QDBusMetaType>
+#include <QDBusVariant>
+#include <QFile>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace PolkitQt1;
+
+static const char s_polkitService[] = "org.freedesktop.PolicyKit1";
+static const char s_polkitPath[] = "/org/freedesktop/PolicyKit1/Authority";
+static const char s_polkitInterface[] = "org.freedesktop.PolicyKit1.Authority";
+static const char s_propertiesInterface[] = "org.freedesktop.DBus.Properties";
+static const char s_errorFailed[] = "org.freedesktop.PolicyKit1.Error.Failed";
+static const char s_errorCancelled[] = "org.freedesktop.PolicyKit1.Error.Cancelled";
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeAction &action)
+{
+    argument.beginStructure();
+    argument << action.actionId << action.description << action.message
+             << action.vendorName << action.vendorUrl << action.iconName
+             << action.implicitAny << action.implicitInactive << action.implicitActive
+             << action.annotations;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeAction &action)
+{
+    argument.beginStructure();
+    argument >> action.actionId >> action.description >> action.message
+             >> action.vendorName >> action.vendorUrl >> action.iconName
+             >> action.implicitAny >> action.implicitInactive >> action.implicitActive
+             >> action.annotations;
+    argument.endStructure();
+    return argument;
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeTemporaryAuthorization &authorization)
+{
+    argument.beginStructure();
+    argument << authorization.id << authorization.actionId;
+    argument.beginStructure();
+    argument << authorization.subjectKind << authorization.subjectDetails;
+    argument.endStructure();
+    argument << authorization.timeObtained << authorization.timeExpires;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeTemporaryAuthorization &authorization)
+{
+    argument.beginStructure();
+    argument >> authorization.id >> authorization.actionId;
+    argument.beginStructure();
+    argument >> authorization.subjectKind >> authorization.subjectDetails;
+    argument.endStructure();
+    argument >> authorization.timeObtained >> authorization.timeExpires;
+    argument.endStructure();
+    return argument;
+}
+
+FakeAuthority::FakeAuthority(const QDBusConnection &bus, QObject *parent)
+        : QDBusVirtualObject(parent)
+        , m_bus(bus)
+        , m_cancelledCount(0)
+        , m_latency(0)
+{
+    qDBusRegisterMetaType<QMap<QString, QString> >();
+    qDBusRegisterMetaType<FakeAction>();
+    qDBusRegisterMetaType<QList<FakeAction> >();
+    qDBusRegisterMetaType<FakeTemporaryAuthorization>();
+    qDBusRegisterMetaType<QList<FakeTemporaryAuthorization> >();
+}
+
+FakeAuthority::~FakeAuthority()
+{
+}
+
+void FakeAuthority::setRule(const QString &actionId, Authority::Result result, Authority::Result challengeResult)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rules.insert(actionId, Rule{result, challengeResult});
+}
+
+void FakeAuthority::removeRule(const QString &actionId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rules.remove(actionId);
+}
+
+void FakeAuthority::clearRules()
+{
+    QMutexLocker locker(&m_mutex);
+    m_rules.clear();
+}
+
+void FakeAuthority::setLatency(int msec)
+{
+    QMutexLocker locker(&m_mutex);
+    m_latency = msec;
+}
+
+int FakeAuthority::latency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_latency;
+}
+
+void FakeAuthority::setFailure(const QString &method, const QString &errorName, const QString &errorMessage)
+{
+    QMutexLocker locker(&m_mutex);
+    if (errorName.isEmpty()) {
+        m_failures.remove(method);
+    } else {
+        m_failures.insert(method, qMakePair(errorName, errorMessage));
+    }
+}
+
+void FakeAuthority::clearFailures()
+{
+    QMutexLocker locker(&m_mutex);
+    m_failures.clear();
+}
+
+void FakeAuthority::addTemporaryAuthorization(const FakeTemporaryAuthorization &authorization)
+{
+    QMutexLocker locker(&m_mutex);
+    m_temporaryAuthorizations.append(authorization);
+}
+
+QList<FakeTemporaryAuthorization> FakeAuthority::temporaryAuthorizations() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_temporaryAuthorizations;
+}
+
+void FakeAuthority::emitChanged()
+{
+    m_bus.send(QDBusMessage::createSignal(QLatin1String(s_polkitPath), QLatin1String(s_polkitInterface),
+                                          QStringLiteral("Changed")));
+}
+
+int FakeAuthority::callCount(const QString &method) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_callCounts.value(method);
+}
+
+int FakeAuthority::cancelledCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cancelledCount;
+}
+
+QString FakeAuthority::lastResponseCookie() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastResponseCookie;
+}
+
+void FakeAuthority::resetCounters()
+{
+    QMutexLocker locker(&m_mutex);
+    m_callCounts.clear();
+    m_cancelledCount = 0;
+}
+
+QString FakeAuthority::introspect(const QString &path) const
+{
+    Q_UNUSED(path)
+    return QStringLiteral(
+        "<interface name=\"org.freedesktop.PolicyKit1.Authority\">"
+        "<method name=\"EnumerateActions\"><arg type=\"s\" direction=\"in\"/><arg type=\"a(ssssssuuua{ss})\" direction=\"out\"/></method>"
+        "<method name=\"CheckAuthorization\"><arg type=\"(sa{sv})\" direction=\"in\"/><arg type=\"s\" direction=\"in\"/>"
+        "<arg type=\"a{ss}\" direction=\"in\"/><arg type=\"u\" direction=\"in\"/><arg type=\"s\" direction=\"in\"/>"
+        "<arg type=\"(bba{ss})\" direction=\"out\"/></method>"
+        "<method name=\"CancelCheckAuthorization\"><arg type=\"s\" direction=\"in\"/></method>"
+        "<method name=\"EnumerateTemporaryAuthorizations\"><arg type=\"(sa{sv})\" direction=\"in\"/>"
+        "<arg type=\"a(ss(sa{sv})tt)\" direction=\"out\"/></method>"
+        "<method name=\"RevokeTemporaryAuthorizations\"><arg type=\"(sa{sv})\" direction=\"in\"/></method>"
+        "<method name=\"RevokeTemporaryAuthorizationById\"><arg type=\"s\" direction=\"in\"/></method>"
+        "<signal name=\"Changed\"/>"
+        "</interface>");
+}
+
+bool FakeAuthority::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    Q_UNUSED(connection)
+
+    if (message.type() != QDBusMessage::MethodCallMessage) {
+        return false;
+    }
+
+    if (message.interface() == QLatin1String(s_propertiesInterface)) {
+        m_bus.send(properties(message));
+        return true;
+    }
+    if (!message.interface().isEmpty() && message.interface() != QLatin1String(s_polkitInterface)) {
+        return false;
+    }
+
+    const QString method = message.member();
+    QPair<QString, QString> failure;
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_callCounts[method];
+        failure = m_failures.value(method);
+    }
+
+    if (!failure.first.isEmpty()) {
+        reply(message, message.createErrorReply(failure.first, failure.second));
+    } else if (method == QLatin1String("CheckAuthorization")) {
+        const QString cancellationId = message.arguments().value(4).toString();
+        reply(message, checkAuthorization(message),
+              cancellationId.isEmpty() ? QString() : message.service() + QLatin1Char(' ') + cancellationId);
+    } else if (method == QLatin1String("CancelCheckAuthorization")) {
+        // Never delayed, it has to overtake the check it cancels
+        m_bus.send(cancelCheckAuthorization(message));
+    } else if (method == QLatin1String("EnumerateActions")) {
+        reply(message, enumerateActions(message));
+    } else if (method == QLatin1String("EnumerateTemporaryAuthorizations")) {
+        reply(message, enumerateTemporaryAuthorizations(message));
+    } else if (method == QLatin1String("RevokeTemporaryAuthorizations")) {
+        reply(message, revokeTemporaryAuthorizations(message));
+    } else if (method == QLatin1String("RevokeTemporaryAuthorizationById")) {
+        reply(message, revokeTemporaryAuthorizationById(message));
+    } else if (method == QLatin1String("RegisterAuthenticationAgent")
+               || method == QLatin1String("RegisterAuthenticationAgentWithOptions")
+               || method == QLatin1String("UnregisterAuthenticationAgent")) {
+        reply(message, message.createReply());
+    } else if (method == QLatin1String("AuthenticationAgentResponse")
+               || method == QLatin1String("AuthenticationAgentResponse2")) {
+        // AuthenticationAgentResponse2 passes the uid of the agent first
+        const int cookieIndex = method == QLatin1String("AuthenticationAgentResponse") ? 0 : 1;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_lastResponseCookie = message.arguments().value(cookieIndex).toString();
+        }
+        reply(message, message.createReply());
+    } else {
+        m_bus.send(message.createErrorReply(QDBusError::UnknownMethod,
+                                            QStringLiteral("No such method %1").arg(method)));
+    }
+
+    return true;
+}
+
+void FakeAuthority::reply(const QDBusMessage &message, const QDBusMessage &reply, const QString &cancellationId)
+{
+    const int delay = latency();
+    if (delay <= 0) {
+        m_bus.send(reply);
+    } else if (cancellationId.isEmpty()) {
+        QDBusConnection bus = m_bus;
+        QTimer::singleShot(delay, this, [bus, reply]() {
+            bus.send(reply);
+        });
+    } else {
+        m_pendingChecks.insert(cancellationId, qMakePair(message, reply));
+        QTimer::singleShot(delay, this, [this, cancellationId]() {
+            replyPending(cancellationId);
+        });
+    }
+}
+
+void FakeAuthority::replyPending(const QString &cancellationId)
+{
+    // Gone if the check was cancelled meanwhile
+    const auto it = m_pendingChecks.find(cancellationId);
+    if (it != m_pendingChecks.end()) {
+        m_bus.send(it.value().second);
+        m_pendingChecks.erase(it);
+    }
+}
+
+QDBusMessage FakeAuthority::checkAuthorization(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    const QString actionId = arguments.value(1).toString();
+    const bool interactive = arguments.value(3).toUInt() & Authority::AllowUserInteraction;
+
+    Rule rule;
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_rules.constFind(actionId);
+        if (it == m_rules.constEnd()) {
+            return message.createErrorReply(QLatin1String(s_errorFailed),
+                                            QStringLiteral("Action %1 is not registered").arg(actionId));
+        }
+        rule = it.value();
+    }
+
+    Authority::Result result = rule.result;
+    if (result == Authority::Challenge && interactive) {
+        result = rule.challengeResult;
+    }
+
+    // Like polkitd, a retained authorization answers the challenge
+    QMap<QString, QString> resultDetails;
+    if (result == Authority::Challenge) {
+        QMutexLocker locker(&m_mutex);
+        const QList<FakeTemporaryAuthorization> &authorizations = m_temporaryAuthorizations;
+        for (const FakeTemporaryAuthorization &authorization : authorizations) {
+            if (authorization.actionId == actionId) {
+                result = Authority::Yes;
+                resultDetails.insert(QStringLiteral("polkit.temporary_authorization_id"), authorization.id);
+                break;
+            }
+        }
+    }
+
+    QDBusArgument argument;
+    argument.beginStructure();
+    argument << (result == Authority::Yes) << (result == Authority::Challenge) << resultDetails;
+    argument.endStructure();
+    return message.createReply(QVariant::fromValue(argument));
+}
+
+QDBusMessage FakeAuthority::cancelCheckAuthorization(const QDBusMessage &message)
+{
+    const QString cancellationId = message.service() + QLatin1Char(' ') + message.arguments().value(0).toString();
+    const auto it = m_pendingChecks.find(cancellationId);
+    if (it == m_pendingChecks.end()) {
+        return message.createErrorReply(QLatin1String(s_errorFailed),
+                                        QStringLiteral("No such cancellation_id %1").arg(message.arguments().value(0).toString()));
+    }
+
+    const QDBusMessage check = it.value().first;
+    m_pendingChecks.erase(it);
+    m_bus.send(check.createErrorReply(QLatin1String(s_errorCancelled),
+                                      QStringLiteral("The authorization check was cancelled")));
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_cancelledCount;
+    }
+    return message.createReply();
+}
+
+QDBusMessage FakeAuthority::enumerateActions(const QDBusMessage &message) const
+{
+    QList<FakeAction> actions;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_rules.constBegin(); it != m_rules.constEnd(); ++it) {
+            quint32 implicit = ActionDescription::AuthenticationRequired;
+            if (it.value().result == Authority::Yes) {
+                implicit = ActionDescription::Authorized;
+            } else if (it.value().result == Authority::No) {
+                implicit = ActionDescription::NotAuthorized;
+            }
+
+            FakeAction action;
+            action.actionId = it.key();
+            action.description = QStringLiteral("Fake action %1").arg(it.key());
+            action.message = QStringLiteral("Authentication is required for %1").arg(it.key());
+            action.vendorName = QStringLiteral("Polkit-qt");
+            action.vendorUrl = QStringLiteral("https://invent.kde.org/libraries/polkit-qt-1");
+            action.implicitAny = implicit;
+            action.implicitInactive = implicit;
+            action.implicitActive = implicit;
+            actions.append(action);
+        }
+    }
+
+    std::sort(actions.begin(), actions.end(), [](const FakeAction &a, const FakeAction &b) {
+        return a.actionId < b.actionId;
+    });
+    return message.createReply(QVariant::fromValue(actions));
+}
+
+QDBusMessage FakeAuthority::enumerateTemporaryAuthorizations(const QDBusMessage &message) const
+{
+    // The subject is not checked, every caller owns all temporary authorizations
+    return message.createReply(QVariant::fromValue(temporaryAuthorizations()));
+}
+
+QDBusMessage FakeAuthority::revokeTemporaryAuthorizations(const QDBusMessage &message)
+{
+    QMutexLocker locker(&m_mutex);
+    m_temporaryAuthorizations.clear();
+    return message.createReply();
+}
+
+QDBusMessage FakeAuthority::revokeTemporaryAuthorizationById(const QDBusMessage &message)
+{
+    const QString id = message.arguments().value(0).toString();
+
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_temporaryAuthorizations.size(); ++i) {
+        if (m_temporaryAuthorizations.at(i).id == id) {
+            m_temporaryAuthorizations.removeAt(i);
+            return message.createReply();
+        }
+    }
+    return message.createErrorReply(QLatin1String(s_errorFailed),
+                                    QStringLiteral("No such authorization with id %1").arg(id));
+}
+
+QDBusMessage FakeAuthority::properties(const QDBusMessage &message) const
+{
+    QVariantMap properties;
+    properties.insert(QStringLiteral("BackendName"), QStringLiteral("fake"));
+    properties.insert(QStringLiteral("BackendVersion"), QStringLiteral("0"));
+    properties.insert(QStringLiteral("BackendFeatures"), quint32(0));
+
+    const QList<QVariant> arguments = message.arguments();
+    if (arguments.value(0).toString() != QLatin1String(s_polkitInterface)) {
+        return message.createErrorReply(QDBusError::UnknownInterface, arguments.value(0).toString());
+    }
+
+    if (message.member() == QLatin1String("GetAll")) {
+        return message.createReply(properties);
+    } else if (message.member() == QLatin1String("Get") && properties.contains(arguments.value(1).toString())) {
+        return message.createReply(QVariant::fromValue(QDBusVariant(properties.value(arguments.value(1).toString()))));
+    }
+    return message.createErrorReply(QDBusError::InvalidArgs, QStringLiteral("Properties are read-only"));
+}
+
+// ----- FakePolkit
+FakePolkit::FakePolkit()
+        : m_authority(nullptr)
+{
+    m_thread.setObjectName(QStringLiteral("fake-polkitd"));
+}
+
+FakePolkit::~FakePolkit()
+{
+    if (m_authority != nullptr) {
+        QDBusConnection bus = QDBusConnection(QStringLiteral("polkit_qt_fake_authority"));
+        bus.unregisterObject(QLatin1String(s_polkitPath));
+        // Deleted by its own thread, which owns its timers
+        QObject::connect(&m_thread, &QThread::finished, m_authority, &QObject::deleteLater);
+        m_thread.quit();
+        m_thread.wait();
+        QDBusConnection::disconnectFromBus(QStringLiteral("polkit_qt_fake_authority"));
+    }
+
+    if (m_daemon.state() != QProcess::NotRunning) {
+        m_daemon.terminate();
+        m_daemon.waitForFinished();
+    }
+}
+
+bool FakePolkit::start()
+{
+    if (!m_dir.isValid()) {
+        return false;
+    }
+
+    QFile config(m_dir.filePath(QStringLiteral("bus.conf")));
+    if (!config.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    config.write("<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\"\n"
+                 " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+                 "<busconfig>\n"
+                 "  <listen>unix:tmpdir=" + QFile::encodeName(m_dir.path()) + "</listen>\n"
+                 "  <auth>EXTERNAL</auth>\n"
+                 "  <policy context=\"default\">\n"
+                 "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+                 "    <allow eavesdrop=\"true\"/>\n"
+                 "    <allow own=\"*\"/>\n"
+                 "  </policy>\n"
+                 "</busconfig>\n");
+    config.close();
+
+    m_daemon.start(QStringLiteral("dbus-daemon"),
+                   QStringList() << QStringLiteral("--config-file=") + config.fileName()
+                                 << QStringLiteral("--nofork")
+                                 << QStringLiteral("--print-address"));
+    if (!m_daemon.waitForStarted()) {
+        return false;
+    }
+    while (!m_daemon.canReadLine()) {
+        if (!m_daemon.waitForReadyRead(5000)) {
+            return false;
+        }
+    }
+    m_address = QString::fromUtf8(m_daemon.readLine()).trimmed();
+
+    // Read by libdbus and GDBus alike, so both backends of Authority end up on the private bus
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", m_address.toUtf8());
+
+    QDBusConnection bus = QDBusConnection::connectToBus(m_address, QStringLiteral("polkit_qt_fake_authority"));
+    if (!bus.isConnected()) {
+        return false;
+    }
+
+    m_authority = new FakeAuthority(bus);
+    m_authority->moveToThread(&m_thread);
+    m_thread.start();
+
+    return bus.registerVirtualObject(QLatin1String(s_polkitPath), m_authority)
+           && bus.registerService(QLatin1String(s_polkitService));
+}
+
+bool FakePolkit::restart()
+{
+    QDBusConnection bus = QDBusConnection(QStringLiteral("polkit_qt_fake_authority"));
+    return bus.unregisterService(QLatin1String(s_polkitService))
+           && bus.registerService(QLatin1String(s_polkitService));
+}
+
+QString FakePolkit::address() const
+{
+    return m_address;
+}
+
+FakeAuthority *FakePolkit::authority() const
+{
+    return m_authority;
+}
@@ -0,0 +1,202 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef FAKEAUTHORITY_H
+#define FAKEAUTHORITY_H
+
+#include <polkitqt1-authority.h>
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVirtualObject>
+#include <QHash>
+#include <QMutex>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+
+/**
+ * One action as returned by EnumerateActions, signature (ssssssuuua{ss})
+ */
+struct FakeAction
+{
+    QString actionId;
+    QString description;
+    QString message;
+    QString vendorName;
+    QString vendorUrl;
+    QString iconName;
+    quint32 implicitAny = 0;
+    quint32 implicitInactive = 0;
+    quint32 implicitActive = 0;
+    QMap<QString, QString> annotations;
+};
+Q_DECLARE_METATYPE(FakeAction)
+
+/**
+ * One temporary authorization as returned by EnumerateTemporaryAuthorizations,
+ * signature (ss(sa{sv})tt)
+ */
+struct FakeTemporaryAuthorization
+{
+    QString id;
+    QString actionId;
+    QString subjectKind;
+    QVariantMap subjectDetails;
+    quint64 timeObtained = 0;
+    quint64 timeExpires = 0;
+};
+Q_DECLARE_METATYPE(FakeTemporaryAuthorization)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeAction &action);
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeAction &action);
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeTemporaryAuthorization &authorization);
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeTemporaryAuthorization &authorization);
+
+/**
+ * Stand-in for polkitd: serves org.freedesktop.PolicyKit1.Authority from a
+ * table of rules instead of the installed .policy files.
+ *
+ * Calls are answered in the thread the object lives in, so it can be moved
+ * to a thread of its own and still answer the synchronous calls of an
+ * Authority living in the main thread. The configuration methods may be
+ * called from any thread.
+ *
+ * Checks of actions without a rule fail like polkitd does for unknown
+ * actions. A temporary authorization for an action turns its challenge into
+ * \c Yes, reported with the id of the authorization. Every reply can be delayed by setLatency(), and any method can be
+ * made to fail with setFailure(). A check started with a cancellation id
+ * stays pending until its latency elapsed, so CancelCheckAuthorization can
+ * cancel it in the meantime.
+ */
+class FakeAuthority : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    explicit FakeAuthority(const QDBusConnection &bus, QObject *parent = nullptr);
+    ~FakeAuthority() override;
+
+    /**
+     * Makes checks of \p actionId return \p result. Challenge answers
+     * non-interactive checks with the challenge flag, interactive ones with
+     * \p challengeResult, as if the user had authenticated.
+     */
+    void setRule(const QString &actionId, PolkitQt1::Authority::Result result,
+                 PolkitQt1::Authority::Result challengeResult = PolkitQt1::Authority::Yes);
+    void removeRule(const QString &actionId);
+    void clearRules();
+
+    /**
+     * Delays every reply except those of CancelCheckAuthorization and the
+     * properties by \p msec milliseconds.
+     */
+    void setLatency(int msec);
+    int latency() const;
+
+    /**
+     * Makes every call of \p method fail with the D-Bus error \p errorName.
+     * An empty \p errorName makes the method work again.
+     */
+    void setFailure(const QString &method, const QString &errorName,
+                    const QString &errorMessage = QString());
+    void clearFailures();
+
+    void addTemporaryAuthorization(const FakeTemporaryAuthorization &authorization);
+    QList<FakeTemporaryAuthorization> temporaryAuthorizations() const;
+
+    /**
+     * Emits the Changed signal, as polkitd does when the configuration changes.
+     */
+    void emitChanged();
+
+    /**
+     * \return the number of calls of \p method received so far
+     */
+    int callCount(const QString &method) const;
+
+    /**
+     * \return the number of checks answered with the Cancelled error
+     */
+    int cancelledCount() const;
+
+    /**
+     * \return the cookie of the last AuthenticationAgentResponse call
+     */
+    QString lastResponseCookie() const;
+
+    void resetCounters();
+
+    QString introspect(const QString &path) const override;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+private:
+    struct Rule
+    {
+        PolkitQt1::Authority::Result result;
+        PolkitQt1::Authority::Result challengeResult;
+    };
+
+    void reply(const QDBusMessage &message, const QDBusMessage &reply, const QString &cancellationId = QString());
+    void replyPending(const QString &cancellationId);
+    QDBusMessage checkAuthorization(const QDBusMessage &message);
+    QDBusMessage cancelCheckAuthorization(const QDBusMessage &message);
+    QDBusMessage enumerateActions(const QDBusMessage &message) const;
+    QDBusMessage enumerateTemporaryAuthorizations(const QDBusMessage &message) const;
+    QDBusMessage revokeTemporaryAuthorizations(const QDBusMessage &message);
+    QDBusMessage revokeTemporaryAuthorizationById(const QDBusMessage &message);
+    QDBusMessage properties(const QDBusMessage &message) const;
+
+    QDBusConnection m_bus;
+    mutable QMutex m_mutex;
+    QHash<QString, Rule> m_rules;
+    QHash<QString, QPair<QString, QString> > m_failures;
+    QList<FakeTemporaryAuthorization> m_temporaryAuthorizations;
+    QHash<QString, int> m_callCounts;
+    int m_cancelledCount;
+    int m_latency;
+    QString m_lastResponseCookie;
+    // Delayed checks that have a cancellation id and their replies, only used by the object's thread
+    QHash<QString, QPair<QDBusMessage, QDBusMessage> > m_pendingChecks;
+};
+
+/**
+ * Test fixture running a private dbus-daemon with a FakeAuthority on it.
+ *
+ * start() points the system bus of this process at the private bus, so it
+ * has to be called before Authority::instance() is used for the first time.
+ */
+class FakePolkit
+{
+public:
+    FakePolkit();
+    ~FakePolkit();
+
+    /**
+     * Spawns the bus and registers the service on it.
+     *
+     * \return \c false if dbus-daemon could not be started
+     */
+    bool start();
+
+    /**
+     * Releases the name of polkitd and takes it again, as a restarted
+     * polkitd would.
+     */
+    bool restart();
+
+    QString address() const;
+    FakeAuthority *authority() const;
+
+private:
+    QTemporaryDir m_dir;
+    QProcess m_daemon;
+    QString m_address;
+    QThread m_thread;
+    FakeAuthority *m_authority;
+};
+
+#endif
@@ -0,0 +1,579 @@
+#include "faketest.h"
+#include <polkitqt1-actioncatalog.h>
+#include <polkitqt1-authority.h>
+#include <polkitqt1-identity.h>
+#include <unistd.h>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+using namespace PolkitQt1;
+
+// Unlike test.cpp, these tests only talk to the FakeAuthority on a private bus
+static const QString s_yes = QStringLiteral("org.qt.policykit.fake.yes");
+static const QString s_no = QStringLiteral("org.qt.policykit.fake.no");
+static const QString s_challenge = QStringLiteral("org.qt.policykit.fake.challenge");
+
+void TestFakeAuthority::initTestCase()
+{
+    // Has to happen before the first Authority::instance()
+    if (!m_polkit.start()) {
+        QSKIP("Cannot start a private dbus-daemon");
+    }
+
+    FakeAuthority *fake = m_polkit.authority();
+    fake->setRule(s_yes, Authority::Yes);
+    fake->setRule(s_no, Authority::No);
+    fake->setRule(s_challenge, Authority::Challenge);
+    QVERIFY(Authority::instance()->isReady());
+}
+
+void TestFakeAuthority::cleanup()
+{
+    FakeAuthority *fake = m_polkit.authority();
+    fake->setLatency(0);
+    fake->clearFailures();
+    fake->resetCounters();
+    Authority::instance()->setMaxInFlightChecks(0);
+    Authority::instance()->setMaxQueuedChecks(0);
+    Authority::instance()->setCallTimeout(0);
+    Authority::instance()->setCacheMode(Authority::CacheDisabled);
+    Authority::instance()->clearError();
+}
+
+void TestFakeAuthority::test_Fake_checkAuthorization()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+    QCOMPARE(authority->checkAuthorizationSync(s_no, process, Authority::None), Authority::No);
+    QCOMPARE(authority->checkAuthorizationSync(s_challenge, process, Authority::None), Authority::Challenge);
+    // The fake "authenticates" interactive checks right away
+    QCOMPARE(authority->checkAuthorizationSync(s_challenge, process, Authority::AllowUserInteraction), Authority::Yes);
+    QVERIFY(!authority->hasError());
+    QCOMPARE(m_polkit.authority()->callCount(QStringLiteral("CheckAuthorization")), 4);
+
+    // Unknown actions fail like they do with polkitd
+    QCOMPARE(authority->checkAuthorizationSync(QStringLiteral("org.qt.policykit.fake.unknown"), process, Authority::None),
+             Authority::Unknown);
+    QVERIFY(authority->hasError());
+    authority->clearError();
+
+    // Details converted once, for any number of checks
+    Details details;
+    details.insert(QStringLiteral("polkit.message"), QStringLiteral("Testing"));
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(authority->checkAuthorizationSyncWithDetails(s_yes, process, Authority::None, details), Authority::Yes);
+    }
+    QSignalSpy spy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+    authority->checkAuthorizationWithDetails(s_no, process, Authority::None, details);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst()[0].value<PolkitQt1::Authority::Result>(), Authority::No);
+}
+
+void TestFakeAuthority::test_Fake_checkAuthorizationAsync()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    QSignalSpy spy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+    authority->checkAuthorization(s_no, process, Authority::None);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst()[0].value<PolkitQt1::Authority::Result>(), Authority::No);
+
+    QFuture<Authority::Result> future = authority->checkAuthorizationAsync(s_yes, process, Authority::None);
+    QTRY_VERIFY(future.isFinished());
+    QCOMPARE(future.result(), Authority::Yes);
+    QVERIFY(!authority->hasError());
+}
+
+void TestFakeAuthority::test_Fake_cancel()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+    // Keep the checks pending long enough to cancel them
+    fake->setLatency(2000);
+
+    authority->resetStatistics();
+
+    QSignalSpy spy(authority, SIGNAL(checkAuthorizationFinished(PolkitQt1::Authority::Result)));
+    authority->checkAuthorization(s_yes, process, Authority::None);
+    QTRY_COMPARE(fake->callCount(QStringLiteral("CheckAuthorization")), 1);
+    authority->checkAuthorizationCancel();
+    QTRY_COMPARE(fake->cancelledCount(), 1);
+    // Counted as cancelled, not as failed
+    QTRY_COMPARE(authority->statistics(Authority::CheckAuthorizationOperation).cancellations, quint64(1));
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).errors, quint64(0));
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!authority->hasError());
+
+    QFuture<Authority::Result> future = authority->checkAuthorizationAsync(s_yes, process, Authority::None);
+    QTRY_COMPARE(fake->callCount(QStringLiteral("CheckAuthorization")), 2);
+    future.cancel();
+    QTRY_COMPARE(fake->cancelledCount(), 2);
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(future.isCanceled());
+    QVERIFY(!authority->hasError());
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).cancellations, quint64(2));
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).errors, quint64(0));
+}
+
+void TestFakeAuthority::test_Fake_failure()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+
+    fake->setFailure(QStringLiteral("CheckAuthorization"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"),
+                     QStringLiteral("Injected failure"));
+    Authority::CheckResult result = authority->checkAuthorizationResultSync(s_yes, process, Authority::None);
+    QVERIFY(result.isError());
+    QCOMPARE(result.result, Authority::Unknown);
+    QVERIFY(result.errorDetails.contains(QLatin1String("Injected failure")));
+
+    fake->setFailure(QStringLiteral("CheckAuthorization"), QString());
+    result = authority->checkAuthorizationResultSync(s_yes, process, Authority::None);
+    QVERIFY(!result.isError());
+    QCOMPARE(result.result, Authority::Yes);
+
+    fake->setFailure(QStringLiteral("EnumerateActions"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"));
+    QVERIFY(authority->enumerateActionsSync().isEmpty());
+    QVERIFY(authority->hasError());
+}
+
+void TestFakeAuthority::test_Fake_latency()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    m_polkit.authority()->setLatency(20);
+
+    // All checks are in flight at the same time, so they take about one latency together
+    QList<QFuture<Authority::Result> > futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.append(authority->checkAuthorizationAsync(i % 2 ? s_yes : s_no, process, Authority::None));
+    }
+    for (int i = 0; i < futures.size(); ++i) {
+        QTRY_VERIFY(futures.at(i).isFinished());
+        QCOMPARE(futures.at(i).result(), i % 2 ? Authority::Yes : Authority::No);
+    }
+    QCOMPARE(m_polkit.authority()->callCount(QStringLiteral("CheckAuthorization")), 100);
+}
+
+void TestFakeAuthority::test_Fake_scheduler()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+    fake->setLatency(200);
+    authority->setMaxInFlightChecks(2);
+    authority->setMaxQueuedChecks(3);
+
+    QList<QFuture<Authority::CheckResult> > futures;
+    for (int i = 0; i < 6; ++i) {
+        futures.append(authority->checkAuthorizationResultAsync(s_yes, process, Authority::None));
+    }
+    QCOMPARE(authority->inFlightChecks(), 2);
+    QCOMPARE(authority->queuedChecks(), 3);
+    // The sixth check found the queue full
+    QVERIFY(futures.at(5).isFinished());
+    QCOMPARE(futures.at(5).result().error, Authority::E_Overloaded);
+
+    for (int i = 0; i < 5; ++i) {
+        QTRY_VERIFY(futures.at(i).isFinished());
+        QCOMPARE(futures.at(i).result().result, Authority::Yes);
+    }
+    QCOMPARE(fake->callCount(QStringLiteral("CheckAuthorization")), 5);
+    QCOMPARE(authority->inFlightChecks(), 0);
+    QCOMPARE(authority->queuedChecks(), 0);
+}
+
+void TestFakeAuthority::test_Fake_timeout()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+    fake->setLatency(5000);
+    authority->setCallTimeout(100);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    Authority::CheckResult result = authority->checkAuthorizationResultSync(s_yes, process, Authority::None);
+    QCOMPARE(result.error, Authority::E_Timeout);
+    QVERIFY(elapsed.elapsed() < 4000);
+    // The check is cancelled on the side of polkitd as well
+    QTRY_COMPARE(fake->cancelledCount(), 1);
+
+    QFuture<Authority::CheckResult> future = authority->checkAuthorizationResultAsync(s_yes, process, Authority::None);
+    QTRY_VERIFY_WITH_TIMEOUT(future.isFinished(), 4000);
+    QVERIFY(!future.isCanceled());
+    QCOMPARE(future.result().error, Authority::E_Timeout);
+    QTRY_COMPARE(fake->cancelledCount(), 2);
+
+    QFuture<ActionDescription::List> actions = authority->enumerateActionsAsync();
+    QTRY_VERIFY_WITH_TIMEOUT(actions.isFinished(), 4000);
+    QVERIFY(actions.result().isEmpty());
+    QCOMPARE(authority->lastError(), Authority::E_Timeout);
+}
+
+void TestFakeAuthority::test_Fake_reconnect()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+    const int reconnects = authority->reconnectCount();
+    QSignalSpy reconnected(authority, SIGNAL(reconnected()));
+    QSignalSpy configChanged(authority, SIGNAL(configChanged()));
+
+    // Leave an error behind, as calls failing during the restart would
+    fake->setFailure(QStringLiteral("EnumerateActions"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"));
+    QVERIFY(authority->enumerateActionsSync().isEmpty());
+    QVERIFY(authority->hasError());
+    fake->setFailure(QStringLiteral("EnumerateActions"), QString());
+
+    QVERIFY(m_polkit.restart());
+    QTRY_COMPARE(reconnected.count(), 1);
+    QCOMPARE(authority->reconnectCount(), reconnects + 1);
+    QVERIFY(configChanged.count() >= 1);
+    QVERIFY(authority->isReady());
+    QVERIFY(!authority->hasError());
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+}
+
+void TestFakeAuthority::test_Fake_enumerateActions()
+{
+    ActionDescription::List actions = Authority::instance()->enumerateActionsSync();
+    QCOMPARE(actions.size(), 3);
+    // Sorted by action id
+    QCOMPARE(actions.at(0).actionId(), s_challenge);
+    QCOMPARE(actions.at(0).implicitActive(), ActionDescription::AuthenticationRequired);
+    QCOMPARE(actions.at(1).actionId(), s_no);
+    QCOMPARE(actions.at(1).implicitActive(), ActionDescription::NotAuthorized);
+    QCOMPARE(actions.at(2).actionId(), s_yes);
+    QCOMPARE(actions.at(2).implicitActive(), ActionDescription::Authorized);
+}
+
+void TestFakeAuthority::test_Fake_enumerateActionsChunked()
+{
+    Authority *authority = Authority::instance();
+    QList<int> chunkSizes;
+    QStringList actionIds;
+    QMetaObject::Connection chunkConnection = connect(authority, &Authority::enumerateActionsChunkReady,
+                                                      [&](const ActionDescription::List &actions) {
+        chunkSizes.append(actions.size());
+        for (const ActionDescription &action : actions) {
+            actionIds.append(action.actionId());
+        }
+    });
+    QSignalSpy finished(authority, SIGNAL(enumerateActionsChunkedFinished(PolkitQt1::Authority::ErrorCode,bool)));
+    auto takeFinished = [&finished]() {
+        const QVariantList arguments = finished.takeFirst();
+        return qMakePair(arguments.at(0).value<Authority::ErrorCode>(), arguments.at(1).toBool());
+    };
+
+    authority->enumerateActionsChunked(2);
+    QVERIFY(finished.wait());
+    QVERIFY(!authority->hasError());
+    QCOMPARE(chunkSizes, QList<int>() << 2 << 1);
+    QCOMPARE(actionIds, QStringList() << s_challenge << s_no << s_yes);
+    QCOMPARE(takeFinished(), qMakePair(Authority::E_None, false));
+
+    // Cancelled between two chunks, the stream still ends
+    chunkSizes.clear();
+    actionIds.clear();
+    QMetaObject::Connection cancelConnection = connect(authority, &Authority::enumerateActionsChunkReady,
+                                                       authority, &Authority::enumerateActionsCancel);
+    authority->enumerateActionsChunked(1);
+    QVERIFY(finished.wait());
+    disconnect(cancelConnection);
+    QCOMPARE(chunkSizes, QList<int>() << 1);
+    QCOMPARE(takeFinished(), qMakePair(Authority::E_None, true));
+
+    // Calls after the cancellation are not affected by it
+    chunkSizes.clear();
+    actionIds.clear();
+    authority->enumerateActionsChunked(2);
+    QVERIFY(finished.wait());
+    QCOMPARE(actionIds, QStringList() << s_challenge << s_no << s_yes);
+    QCOMPARE(takeFinished(), qMakePair(Authority::E_None, false));
+
+    // A failure ends the stream as well
+    m_polkit.authority()->setFailure(QStringLiteral("EnumerateActions"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"));
+    chunkSizes.clear();
+    authority->enumerateActionsChunked(2);
+    QVERIFY(finished.wait());
+    disconnect(chunkConnection);
+    QVERIFY(chunkSizes.isEmpty());
+    QCOMPARE(takeFinished(), qMakePair(Authority::E_EnumFailed, false));
+    QCOMPARE(authority->lastError(), Authority::E_EnumFailed);
+}
+
+void TestFakeAuthority::test_Fake_actionCatalog()
+{
+    FakeAuthority *fake = m_polkit.authority();
+    ActionCatalog catalog;
+    QVERIFY(!catalog.isLoaded());
+    QVERIFY(catalog.refreshSync());
+    QVERIFY(catalog.isLoaded());
+    QCOMPARE(catalog.count(), 3);
+    QCOMPARE(catalog.actionIds(), QStringList() << s_challenge << s_no << s_yes);
+    QCOMPARE(catalog.lookup(s_no).implicitActive(), ActionDescription::NotAuthorized);
+    QVERIFY(catalog.lookup(QStringLiteral("org.qt.policykit.fake.none")).actionId().isEmpty());
+    QCOMPARE(catalog.actionsWithPrefix(QStringLiteral("org.qt.policykit.fake.")).size(), 3);
+    QCOMPARE(catalog.actionsWithPrefix(QStringLiteral("org.qt.policykit.fake.n")).size(), 1);
+    QVERIFY(catalog.actionsWithPrefix(QStringLiteral("org.kde.")).isEmpty());
+
+    QStringList added;
+    QStringList removed;
+    QStringList changed;
+    connect(&catalog, &ActionCatalog::actionsAdded, [&added](const ActionDescription::List &actions) {
+        for (const ActionDescription &action : actions) {
+            added.append(action.actionId());
+        }
+    });
+    connect(&catalog, &ActionCatalog::actionsRemoved, [&removed](const QStringList &actionIds) {
+        removed += actionIds;
+    });
+    connect(&catalog, &ActionCatalog::actionsChanged, [&changed](const ActionDescription::List &actions) {
+        for (const ActionDescription &action : actions) {
+            changed.append(action.actionId());
+        }
+    });
+
+    // A configuration change only reports the differences
+    const QString newAction = QStringLiteral("org.qt.policykit.fake.added");
+    fake->setRule(newAction, Authority::Yes);
+    fake->setRule(s_no, Authority::Yes);
+    fake->removeRule(s_challenge);
+    QSignalSpy refreshed(&catalog, SIGNAL(refreshed()));
+    fake->emitChanged();
+    QVERIFY(refreshed.wait());
+    QCOMPARE(added, QStringList() << newAction);
+    QCOMPARE(removed, QStringList() << s_challenge);
+    QCOMPARE(changed, QStringList() << s_no);
+    QCOMPARE(catalog.actionIds(), QStringList() << newAction << s_no << s_yes);
+    QCOMPARE(catalog.lookup(s_no).implicitActive(), ActionDescription::Authorized);
+
+    // Nothing changed, nothing reported
+    added.clear();
+    removed.clear();
+    changed.clear();
+    catalog.refresh();
+    QVERIFY(catalog.isRefreshing());
+    QVERIFY(refreshed.wait());
+    QVERIFY(added.isEmpty() && removed.isEmpty() && changed.isEmpty());
+
+    // A failed refresh keeps the catalog as it is
+    fake->setFailure(QStringLiteral("EnumerateActions"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"));
+    QVERIFY(!catalog.refreshSync());
+    QCOMPARE(catalog.count(), 3);
+    QVERIFY(!Authority::instance()->hasError());
+    fake->clearFailures();
+
+    // An error left behind by another call fails neither kind of refresh
+    QCOMPARE(Authority::instance()->enumerateActionsResultSync().actions.size(), 3);
+    fake->setFailure(QStringLiteral("EnumerateActions"), QStringLiteral("org.freedesktop.PolicyKit1.Error.Failed"));
+    QVERIFY(Authority::instance()->enumerateActionsSync().isEmpty());
+    QVERIFY(Authority::instance()->hasError());
+    fake->clearFailures();
+    QVERIFY(catalog.refreshSync());
+    catalog.refresh();
+    QVERIFY(refreshed.wait());
+    QVERIFY(Authority::instance()->hasError());
+
+    fake->removeRule(newAction);
+    fake->setRule(s_no, Authority::No);
+    fake->setRule(s_challenge, Authority::Challenge);
+}
+
+void TestFakeAuthority::test_Fake_actionSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QStringLiteral("/cache/actions.snapshot");
+
+    ActionCatalog writer;
+    QVERIFY(!writer.loadSnapshot());
+    writer.setSnapshotFile(fileName);
+    QVERIFY(!writer.loadSnapshot());
+    QVERIFY(writer.refreshSync());
+    QVERIFY(QFile::exists(fileName));
+
+    // Filled without a call to polkitd
+    FakeAuthority *fake = m_polkit.authority();
+    fake->resetCounters();
+    ActionCatalog reader;
+    reader.setSnapshotFile(fileName);
+    QVERIFY(reader.loadSnapshot());
+    QVERIFY(reader.isLoaded());
+    QCOMPARE(fake->callCount(QStringLiteral("EnumerateActions")), 0);
+    QCOMPARE(reader.actions(), writer.actions());
+    QCOMPARE(reader.lookup(s_no).message(), writer.lookup(s_no).message());
+    QCOMPARE(reader.lookup(s_no).implicitActive(), ActionDescription::NotAuthorized);
+
+    // A damaged file is not used. A copy is damaged, reader still maps the original.
+    const QString damagedName = dir.path() + QStringLiteral("/cache/damaged.snapshot");
+    QVERIFY(QFile::copy(fileName, damagedName));
+    QFile file(damagedName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 1));
+    file.close();
+    ActionCatalog damaged;
+    damaged.setSnapshotFile(damagedName);
+    QVERIFY(!damaged.loadSnapshot());
+    QVERIFY(!damaged.isLoaded());
+}
+
+static FakeTemporaryAuthorization temporaryAuthorization(const QString &id, const QString &actionId)
+{
+    FakeTemporaryAuthorization authorization;
+    authorization.id = id;
+    authorization.actionId = actionId;
+    authorization.subjectKind = QStringLiteral("unix-process");
+    authorization.subjectDetails.insert(QStringLiteral("pid"), quint32(QCoreApplication::applicationPid()));
+    authorization.subjectDetails.insert(QStringLiteral("start-time"), quint64(0));
+    authorization.subjectDetails.insert(QStringLiteral("uid"), qint32(getuid()));
+    authorization.timeObtained = 1000;
+    authorization.timeExpires = 2000;
+    return authorization;
+}
+
+void TestFakeAuthority::test_Fake_temporaryAuthorizations()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+
+    const FakeTemporaryAuthorization authorization = temporaryAuthorization(QStringLiteral("tmpauthz1"), s_challenge);
+    fake->addTemporaryAuthorization(authorization);
+
+    TemporaryAuthorization::List list = authority->enumerateTemporaryAuthorizationsSync(process);
+    QCOMPARE(list.size(), 1);
+    QCOMPARE(list.first().id(), authorization.id);
+    QCOMPARE(list.first().actionId(), s_challenge);
+
+    QVERIFY(authority->revokeTemporaryAuthorizationSync(authorization.id));
+    QVERIFY(fake->temporaryAuthorizations().isEmpty());
+    // Gone, so the second revocation fails
+    QVERIFY(!authority->revokeTemporaryAuthorizationSync(authorization.id));
+    authority->clearError();
+
+    fake->addTemporaryAuthorization(authorization);
+    QVERIFY(authority->revokeTemporaryAuthorizationsSync(process));
+    QVERIFY(authority->enumerateTemporaryAuthorizationsSync(process).isEmpty());
+}
+
+void TestFakeAuthority::test_Fake_temporaryAuthorizationCache()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    FakeAuthority *fake = m_polkit.authority();
+    const QString checkMethod = QStringLiteral("CheckAuthorization");
+    authority->setCacheMode(Authority::CacheDecisions);
+
+    const FakeTemporaryAuthorization authorization = temporaryAuthorization(QStringLiteral("tmpauthz2"), s_challenge);
+    fake->addTemporaryAuthorization(authorization);
+
+    // Yes only while the authorization lasts, so it is asked for every time
+    const Authority::CheckResult retained = authority->checkAuthorizationResultSync(s_challenge, process, Authority::None);
+    QCOMPARE(retained.result, Authority::Yes);
+    QCOMPARE(retained.temporaryAuthorizationId, authorization.id);
+    QCOMPARE(authority->checkAuthorizationSync(s_challenge, process, Authority::None), Authority::Yes);
+    QCOMPARE(fake->callCount(checkMethod), 2);
+
+    // A plain Yes is cached, until an authorization is revoked
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+    QCOMPARE(fake->callCount(checkMethod), 3);
+
+    QVERIFY(authority->revokeTemporaryAuthorizationSync(authorization.id));
+    QCOMPARE(authority->checkAuthorizationSync(s_challenge, process, Authority::None), Authority::Challenge);
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+    QCOMPARE(fake->callCount(checkMethod), 5);
+
+    // The same through the future of a revocation of all authorizations
+    fake->addTemporaryAuthorization(authorization);
+    QFuture<bool> revoked = authority->revokeTemporaryAuthorizationsAsync(process);
+    QTRY_VERIFY(revoked.isFinished());
+    QVERIFY(revoked.result());
+    QCOMPARE(authority->checkAuthorizationSync(s_yes, process, Authority::None), Authority::Yes);
+    QCOMPARE(fake->callCount(checkMethod), 6);
+}
+
+void TestFakeAuthority::test_Fake_changed()
+{
+    Authority *authority = Authority::instance();
+    QSignalSpy spy(authority, SIGNAL(configChanged()));
+    m_polkit.authority()->emitChanged();
+    QVERIFY(spy.wait());
+}
+
+void TestFakeAuthority::test_Fake_loginChanged()
+{
+    Authority *authority = Authority::instance();
+    QList<Authority::LoginChange> changes;
+    QMetaObject::Connection connection = connect(authority, &Authority::loginChanged,
+                                                 [&changes](const Authority::LoginChange &change) {
+        changes.append(change);
+    });
+    QSignalSpy consoleKitDBChanged(authority, SIGNAL(consoleKitDBChanged()));
+
+    // Stands in for logind on the private bus
+    QDBusConnection login1 = QDBusConnection::connectToBus(m_polkit.address(), QStringLiteral("polkit_qt_fake_login1"));
+    QVERIFY(login1.registerService(QStringLiteral("org.freedesktop.login1")));
+    const QString sessionPath = QStringLiteral("/org/freedesktop/login1/session/_31");
+
+    QDBusMessage sessionNew = QDBusMessage::createSignal(QStringLiteral("/org/freedesktop/login1"),
+                                                         QStringLiteral("org.freedesktop.login1.Manager"),
+                                                         QStringLiteral("SessionNew"));
+    sessionNew << QStringLiteral("1") << QVariant::fromValue(QDBusObjectPath(sessionPath));
+    QVERIFY(login1.send(sessionNew));
+    QTRY_COMPARE(changes.size(), 1);
+    QCOMPARE(changes.at(0).kind, Authority::LoginChange::SessionAdded);
+    QCOMPARE(changes.at(0).id, QStringLiteral("1"));
+    QCOMPARE(changes.at(0).objectPath, sessionPath);
+    QCOMPARE(consoleKitDBChanged.count(), 1);
+
+    auto propertiesChanged = [&](const QString &property) {
+        QVariantMap properties;
+        properties.insert(property, true);
+        QDBusMessage message = QDBusMessage::createSignal(sessionPath, QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                          QStringLiteral("PropertiesChanged"));
+        message << QStringLiteral("org.freedesktop.login1.Session") << properties << QStringList();
+        return login1.send(message);
+    };
+
+    // The idle hint does not change what polkitd answers
+    QVERIFY(propertiesChanged(QStringLiteral("IdleHint")));
+    QTRY_COMPARE(changes.size(), 2);
+    QCOMPARE(changes.at(1).kind, Authority::LoginChange::SessionChanged);
+    // The id is unescaped from the object path
+    QCOMPARE(changes.at(1).id, QStringLiteral("1"));
+    QCOMPARE(changes.at(1).objectPath, sessionPath);
+    QCOMPARE(changes.at(1).changedProperties, QStringList() << QStringLiteral("IdleHint"));
+    QCOMPARE(consoleKitDBChanged.count(), 1);
+
+    QVERIFY(propertiesChanged(QStringLiteral("Active")));
+    QTRY_COMPARE(changes.size(), 3);
+    QCOMPARE(changes.at(2).kind, Authority::LoginChange::SessionChanged);
+    QCOMPARE(changes.at(2).changedProperties, QStringList() << QStringLiteral("Active"));
+    QCOMPARE(consoleKitDBChanged.count(), 2);
+
+    disconnect(connection);
+    login1.unregisterService(QStringLiteral("org.freedesktop.login1"));
+    QDBusConnection::disconnectFromBus(QStringLiteral("polkit_qt_fake_login1"));
+}
+
+void TestFakeAuthority::test_Fake_agentResponse()
+{
+    Authority *authority = Authority::instance();
+    QVERIFY(authority->authenticationAgentResponseSync(QStringLiteral("cookie-1"), UnixUserIdentity(getuid())));
+    QCOMPARE(m_polkit.authority()->lastResponseCookie(), QStringLiteral("cookie-1"));
+}
+
+QTEST_MAIN(TestFakeAuthority)
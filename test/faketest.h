@@ -0,0 +1,37 @@
+#ifndef FAKETEST_H
+#define FAKETEST_H
+
+#include "fakeauthority.h"
+
+#include <QObject>
+#include <QTest>
+
+class TestFakeAuthority : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void test_Fake_checkAuthorization();
+    void test_Fake_checkAuthorizationAsync();
+    void test_Fake_cancel();
+    void test_Fake_failure();
+    void test_Fake_latency();
+    void test_Fake_scheduler();
+    void test_Fake_timeout();
+    void test_Fake_reconnect();
+    void test_Fake_enumerateActions();
+    void test_Fake_enumerateActionsChunked();
+    void test_Fake_actionCatalog();
+    void test_Fake_actionSnapshot();
+    void test_Fake_temporaryAuthorizations();
+    void test_Fake_temporaryAuthorizationCache();
+    void test_Fake_changed();
+    void test_Fake_loginChanged();
+    void test_Fake_agentResponse();
+
+private:
+    FakePolkit m_polkit;
+};
+
+#endif // FAKETEST_H
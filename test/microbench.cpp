@@ -0,0 +1,290 @@
+
+#include "microbench.h"
+#include <polkitqt1-conversions_p.h>
+#include <listeneradapter_p.h>
+#include <polkitqt1-policyfilesource.h>
+#include <unistd.h>
+#include <QCoreApplication>
+#include <QExplicitlySharedDataPointer>
+
+#include <malloc.h>
+
+#include <polkit/polkit.h>
+
+using namespace PolkitQt1;
+
+// Micro-benchmarks of the conversions done on every call, run on synthetic
+// polkit-gobject objects so that no polkitd is needed
+
+// Installed with polkit-gobject in polkitprivate.h, which is not part of polkit.h
+extern "C" PolkitActionDescription *polkit_action_description_new_for_gvariant(GVariant *value);
+
+static PolkitActionDescription *newActionDescription(int index)
+{
+    const QByteArray actionId = "org.qt.policykit.bench.action" + QByteArray::number(index);
+    GVariantBuilder annotations;
+    g_variant_builder_init(&annotations, G_VARIANT_TYPE("a{ss}"));
+    g_variant_builder_add(&annotations, "{ss}", "org.freedesktop.policykit.exec.path", "/usr/bin/true");
+    GVariant *value = g_variant_new("(ssssssuuua{ss})",
+                                    actionId.constData(),
+                                    "Benchmark action with a description of typical length",
+                                    "Authentication is required to run the benchmark action",
+                                    "Polkit-qt",
+                                    "https://invent.kde.org/libraries/polkit-qt-1",
+                                    "system-run",
+                                    POLKIT_IMPLICIT_AUTHORIZATION_NOT_AUTHORIZED,
+                                    POLKIT_IMPLICIT_AUTHORIZATION_AUTHENTICATION_REQUIRED,
+                                    POLKIT_IMPLICIT_AUTHORIZATION_ADMINISTRATOR_AUTHENTICATION_REQUIRED_RETAINED,
+                                    &annotations);
+    g_variant_ref_sink(value);
+    PolkitActionDescription *description = polkit_action_description_new_for_gvariant(value);
+    g_variant_unref(value);
+    return description;
+}
+
+void BenchConversions::bench_convertDetailsMap_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1 entry") << 1;
+    QTest::newRow("8 entries") << 8;
+    QTest::newRow("64 entries") << 64;
+}
+
+void BenchConversions::bench_convertDetailsMap()
+{
+    QFETCH(int, count);
+    DetailsMap details;
+    for (int i = 0; i < count; ++i) {
+        details.insert(QStringLiteral("polkit.bench.key%1").arg(i), QStringLiteral("value of detail %1").arg(i));
+    }
+
+    QBENCHMARK {
+        g_object_unref(convertDetailsMap(details));
+    }
+}
+
+void BenchConversions::bench_actionDescription()
+{
+    PolkitActionDescription *description = newActionDescription(0);
+    QVERIFY(description != nullptr);
+
+    QBENCHMARK {
+        ActionDescription action(description);
+        Q_UNUSED(action)
+    }
+    g_object_unref(description);
+}
+
+void BenchConversions::bench_actionsToListAndFree_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("10 actions") << 10;
+    QTest::newRow("100 actions") << 100;
+    QTest::newRow("1000 actions") << 1000;
+}
+
+void BenchConversions::bench_actionsToListAndFree()
+{
+    QFETCH(int, count);
+    QVector<PolkitActionDescription *> descriptions;
+    for (int i = 0; i < count; ++i) {
+        descriptions.append(newActionDescription(i));
+    }
+
+    // Includes building the list, which the conversion consumes
+    QBENCHMARK {
+        GList *list = nullptr;
+        for (int i = descriptions.size() - 1; i >= 0; --i) {
+            list = g_list_prepend(list, g_object_ref(descriptions.at(i)));
+        }
+        ActionDescription::List actions = actionsToListAndFree(list);
+        Q_UNUSED(actions)
+    }
+
+    for (PolkitActionDescription *description : descriptions) {
+        g_object_unref(description);
+    }
+}
+
+// Bytes allocated from the heap right now, -1 if unknown
+static qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return -1;
+#endif
+}
+
+// How ActionDescription::Data was laid out before the texts were shared, for comparison
+struct PlainActionDescription : public QSharedData
+{
+    virtual ~PlainActionDescription() {}
+
+    QString actionId;
+    QString description;
+    QString message;
+    QString vendorName;
+    QString vendorUrl;
+    QString iconName;
+    ActionDescription::ImplicitAuthorization implicitAny;
+    ActionDescription::ImplicitAuthorization implicitInactive;
+    ActionDescription::ImplicitAuthorization implicitActive;
+};
+
+void BenchConversions::bench_actionListMemory()
+{
+    if (heapInUse() < 0) {
+        QSKIP("The heap usage is only known with glibc 2.33 or later");
+    }
+
+    const int count = 1000;
+    QVector<PolkitActionDescription *> descriptions;
+    for (int i = 0; i < count; ++i) {
+        descriptions.append(newActionDescription(i));
+    }
+
+    qint64 start = heapInUse();
+    QList<QExplicitlySharedDataPointer<PlainActionDescription> > plain;
+    for (PolkitActionDescription *description : descriptions) {
+        auto data = new PlainActionDescription;
+        data->actionId = QString::fromUtf8(polkit_action_description_get_action_id(description));
+        data->description = QString::fromUtf8(polkit_action_description_get_description(description));
+        data->message = QString::fromUtf8(polkit_action_description_get_message(description));
+        data->vendorName = QString::fromUtf8(polkit_action_description_get_vendor_name(description));
+        data->vendorUrl = QString::fromUtf8(polkit_action_description_get_vendor_url(description));
+        data->iconName = QString::fromUtf8(polkit_action_description_get_icon_name(description));
+        data->implicitAny = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_any(description));
+        data->implicitInactive = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_inactive(description));
+        data->implicitActive = static_cast<ActionDescription::ImplicitAuthorization>(polkit_action_description_get_implicit_active(description));
+        plain.append(QExplicitlySharedDataPointer<PlainActionDescription>(data));
+    }
+    const qint64 plainBytes = heapInUse() - start;
+    plain.clear();
+
+    start = heapInUse();
+    GList *list = nullptr;
+    for (int i = descriptions.size() - 1; i >= 0; --i) {
+        list = g_list_prepend(list, g_object_ref(descriptions.at(i)));
+    }
+    ActionDescription::List actions = actionsToListAndFree(list);
+    const qint64 compactBytes = heapInUse() - start;
+    QCOMPARE(actions.size(), count);
+    QCOMPARE(actions.last().message(), QStringLiteral("Authentication is required to run the benchmark action"));
+    actions.clear();
+
+    qInfo("Bytes per action: %lld with one QString per field, %lld with shared texts",
+          plainBytes / count, compactBytes / count);
+    QVERIFY(compactBytes < plainBytes);
+
+    for (PolkitActionDescription *description : descriptions) {
+        g_object_unref(description);
+    }
+}
+
+void BenchConversions::bench_policyFileSource()
+{
+    // The installed .policy files, to compare with enumerating them through polkitd
+    PolicyFileSource installed;
+    if (!installed.load()) {
+        QSKIP("No .policy files installed");
+    }
+
+    QBENCHMARK {
+        PolicyFileSource source;
+        source.load();
+    }
+}
+
+void BenchConversions::bench_temporaryAuthorization()
+{
+    PolkitSubject *subject = polkit_unix_process_new_for_owner(QCoreApplication::applicationPid(), 0, getuid());
+    PolkitTemporaryAuthorization *authorization = polkit_temporary_authorization_new("tmpauthz42",
+                                                                                     "org.qt.policykit.bench.action",
+                                                                                     subject, 1000, 2000);
+    g_object_unref(subject);
+
+    QBENCHMARK {
+        // Takes over the reference
+        TemporaryAuthorization temporary(static_cast<PolkitTemporaryAuthorization *>(g_object_ref(authorization)));
+        Q_UNUSED(temporary)
+    }
+    g_object_unref(authorization);
+}
+
+void BenchConversions::bench_subjectToString_data()
+{
+    QTest::addColumn<QString>("string");
+    QTest::newRow("unix-process") << QStringLiteral("unix-process:%1:1234").arg(QCoreApplication::applicationPid());
+    QTest::newRow("unix-session") << QStringLiteral("unix-session:c1");
+    QTest::newRow("system-bus-name") << QStringLiteral("system-bus-name::1.42");
+}
+
+void BenchConversions::bench_subjectToString()
+{
+    QFETCH(QString, string);
+    const Subject subject = Subject::fromString(string);
+    QVERIFY(subject.isValid());
+
+    QBENCHMARK {
+        subject.toString();
+    }
+}
+
+void BenchConversions::bench_subjectFromString_data()
+{
+    bench_subjectToString_data();
+}
+
+void BenchConversions::bench_subjectFromString()
+{
+    QFETCH(QString, string);
+
+    QBENCHMARK {
+        Subject::fromString(string);
+    }
+}
+
+void BenchConversions::bench_identityFromString_data()
+{
+    QTest::addColumn<QString>("string");
+    // Numeric ids, names would measure the user database instead
+    QTest::newRow("unix-user") << QStringLiteral("unix-user:%1").arg(getuid());
+    QTest::newRow("unix-group") << QStringLiteral("unix-group:%1").arg(getgid());
+}
+
+void BenchConversions::bench_identityFromString()
+{
+    QFETCH(QString, string);
+    QVERIFY(Identity::fromString(string).isValid());
+
+    QBENCHMARK {
+        Identity::fromString(string);
+    }
+}
+
+void BenchConversions::bench_uniqueIdentities_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("4 identities") << 4;
+    QTest::newRow("64 identities") << 64;
+}
+
+void BenchConversions::bench_uniqueIdentities()
+{
+    QFETCH(int, count);
+    // Every identity twice, as polkit hands them out for groups with overlapping members
+    GList *identities = nullptr;
+    for (int i = 0; i < count; ++i) {
+        identities = g_list_prepend(identities, polkit_unix_user_new(1000 + i / 2));
+    }
+
+    QBENCHMARK {
+        Agent::uniqueIdentities(identities);
+    }
+    QCOMPARE(Agent::uniqueIdentities(identities).size(), (count + 1) / 2);
+
+    g_list_free_full(identities, g_object_unref);
+}
+
+QTEST_GUILESS_MAIN(BenchConversions)
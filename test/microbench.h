@@ -0,0 +1,29 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <QObject>
+#include <QTest>
+
+class BenchConversions : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void bench_convertDetailsMap_data();
+    void bench_convertDetailsMap();
+    void bench_actionDescription();
+    void bench_actionsToListAndFree_data();
+    void bench_actionsToListAndFree();
+    void bench_actionListMemory();
+    void bench_policyFileSource();
+    void bench_temporaryAuthorization();
+    void bench_subjectToString_data();
+    void bench_subjectToString();
+    void bench_subjectFromString_data();
+    void bench_subjectFromString();
+    void bench_identityFromString_data();
+    void bench_identityFromString();
+    void bench_uniqueIdentities_data();
+    void bench_uniqueIdentities();
+};
+
+#endif // MICROBENCH_H
@@ -0,0 +1,69 @@
+#include "nopolkittest.h"
+#include <polkitqt1-authority.h>
+#include <QFile>
+#include <QFuture>
+#include <QSignalSpy>
+
+using namespace PolkitQt1;
+
+// Calls made without an authority have to fail instead of never finishing
+void TestNoPolkit::initTestCase()
+{
+    // Has to happen before the first Authority::instance(): a system bus nobody
+    // listens on, so the authority cannot even be looked up
+    QVERIFY(m_dir.isValid());
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", "unix:path=" + QFile::encodeName(m_dir.filePath(QStringLiteral("missing"))));
+    QTRY_VERIFY(Authority::instance()->isReady());
+}
+
+void TestNoPolkit::cleanup()
+{
+    Authority::instance()->setMaxInFlightChecks(0);
+    Authority::instance()->clearError();
+}
+
+void TestNoPolkit::test_NoPolkit_checkAuthorization()
+{
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    const QString actionId = QStringLiteral("org.qt.policykit.nopolkit");
+
+    QFuture<Authority::CheckResult> result = authority->checkAuthorizationResultAsync(actionId, process, Authority::None);
+    QTRY_VERIFY(result.isFinished());
+    QVERIFY(result.result().isError());
+
+    QList<Authority::CheckRequest> requests;
+    requests << Authority::CheckRequest(actionId, process) << Authority::CheckRequest(actionId, process);
+    QFuture<QVector<Authority::CheckResult> > batch = authority->checkAuthorizationBatch(requests, Authority::None);
+    QTRY_VERIFY(batch.isFinished());
+    QCOMPARE(batch.result().size(), 2);
+    QVERIFY(batch.result().at(0).isError());
+    QVERIFY(batch.result().at(1).isError());
+
+    // The failed checks have to give their slots back, or the second one would wait forever
+    authority->clearError();
+    authority->setMaxInFlightChecks(1);
+    QFuture<Authority::Result> first = authority->checkAuthorizationAsync(actionId, process, Authority::None);
+    QFuture<Authority::Result> second = authority->checkAuthorizationAsync(actionId, process, Authority::None);
+    QTRY_VERIFY(first.isFinished());
+    QTRY_VERIFY(second.isFinished());
+    QCOMPARE(second.result(), Authority::Unknown);
+}
+
+void TestNoPolkit::test_NoPolkit_enumerateActions()
+{
+    Authority *authority = Authority::instance();
+
+    QFuture<ActionDescription::List> future = authority->enumerateActionsAsync();
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(future.result().isEmpty());
+    QVERIFY(authority->hasError());
+
+    QSignalSpy finished(authority, SIGNAL(enumerateActionsChunkedFinished(PolkitQt1::Authority::ErrorCode,bool)));
+    authority->enumerateActionsChunked();
+    QTRY_COMPARE(finished.count(), 1);
+    QVERIFY(finished.at(0).at(0).value<Authority::ErrorCode>() != Authority::E_None);
+    QVERIFY(!finished.at(0).at(1).toBool());
+}
+
+QTEST_MAIN(TestNoPolkit)
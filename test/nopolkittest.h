@@ -0,0 +1,21 @@
+#ifndef NOPOLKITTEST_H
+#define NOPOLKITTEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestNoPolkit : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void test_NoPolkit_checkAuthorization();
+    void test_NoPolkit_enumerateActions();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+#endif // NOPOLKITTEST_H
@@ -0,0 +1,44 @@
+/*
+    This file is part of the Polkit-qt project
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+// Measures the time from creating the authority to its first authorization
+// result. Pass --sync to compare with the blocking Authority::instance().
+// This needs the file org.qt.policykit.examples.policy from examples to be installed
+
+#include <polkitqt1-authority.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+#include <cstdio>
+
+using namespace PolkitQt1;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const bool sync = app.arguments().contains(QStringLiteral("--sync"));
+
+    QElapsedTimer timer;
+    timer.start();
+    Authority *authority = sync ? Authority::instance() : Authority::instanceAsync();
+    const double created = timer.nsecsElapsed() / 1e6;
+
+    QFutureWatcher<Authority::Result> watcher;
+    QObject::connect(&watcher, &QFutureWatcherBase::finished, [&]() {
+        const double checked = timer.nsecsElapsed() / 1e6;
+        std::printf("%s: instance after %.3f ms, first check after %.3f ms (%s)\n",
+                    sync ? "instance()" : "instanceAsync()", created, checked,
+                    watcher.result() == Authority::Yes ? "authorized" : "not authorized");
+        app.quit();
+    });
+    watcher.setFuture(authority->checkAuthorizationAsync(QStringLiteral("org.qt.policykit.examples.cry"),
+                                                         UnixProcessSubject(QCoreApplication::applicationPid()),
+                                                         Authority::None));
+
+    return app.exec();
+}
@@ -4,12 +4,17 @@
 #include <polkitqt1-authority.h>
 #include <polkitqt1-agent-session.h>
 #include <polkitqt1-details.h>
+#include <polkitqt1-policyfilesource.h>
+#include <polkitqt1-tracer.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <pwd.h>
 #include <QDBusMessage>
 #include <QDBusConnection>
+#include <QFuture>
 #include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QThread>
 
 using namespace PolkitQt1;
 using namespace PolkitQt1::Agent;
@@ -22,6 +27,25 @@ void wait()
     }
 }
 
+class CheckThread : public QThread
+{
+public:
+    void run() override
+    {
+        Authority *authority = Authority::instance();
+        // An invalid subject must only put this thread in error state
+        authority->checkAuthorizationSync("org.qt.policykit.examples.cry", Subject(), Authority::None);
+        failed = authority->hasError();
+        authority->clearError();
+        result = authority->checkAuthorizationSync("org.qt.policykit.examples.cry",
+                                                   UnixProcessSubject(QCoreApplication::applicationPid()),
+                                                   Authority::None);
+    }
+
+    bool failed = false;
+    Authority::Result result = Authority::Unknown;
+};
+
 void TestAuth::test_Auth_checkAuthorization()
 {
     // This needs the file org.qt.policykit.examples.policy from examples to be installed
@@ -71,6 +95,254 @@ void TestAuth::test_Auth_checkAuthorization()
     qWarning() << "You should see an authentication dialog for a short period.";
 }
 
+void TestAuth::test_Auth_ready()
+{
+    Authority *authority = Authority::instance();
+    // The instance already exists, instanceAsync() must not create another one
+    QCOMPARE(Authority::instanceAsync(), authority);
+    QVERIFY(authority->isReady());
+    QVERIFY(authority->polkitAuthority() != nullptr);
+}
+
+void TestAuth::test_Auth_checkAuthorizationAsync()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    // Several checks in flight at once, each result belongs to its own future
+    QFuture<Authority::Result> kick = authority->checkAuthorizationAsync("org.qt.policykit.examples.kick", process, Authority::None);
+    QFuture<Authority::Result> cry = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    QFuture<Authority::Result> bleed = authority->checkAuthorizationAsync("org.qt.policykit.examples.bleed", process, Authority::None);
+    wait();
+    QVERIFY(kick.isFinished() && cry.isFinished() && bleed.isFinished());
+    QCOMPARE(kick.result(), Authority::No);
+    QCOMPARE(cry.result(), Authority::Yes);
+    QCOMPARE(bleed.result(), Authority::Challenge);
+    QVERIFY(!authority->hasError());
+
+    // Cancelling one call must not affect the others
+    QFuture<Authority::Result> cancelled = authority->checkAuthorizationAsync("org.qt.policykit.examples.kick", process, Authority::None);
+    QFuture<Authority::Result> kept = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    cancelled.cancel();
+    wait();
+    QVERIFY(cancelled.isCanceled());
+    QVERIFY(kept.isFinished());
+    QCOMPARE(kept.result(), Authority::Yes);
+    QVERIFY(!authority->hasError());
+}
+
+void TestAuth::test_Auth_cache()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    authority->setCacheMode(Authority::CacheDecisions);
+
+    const quint64 hits = authority->cacheHits();
+    const quint64 misses = authority->cacheMisses();
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None), Authority::Yes);
+    QCOMPARE(authority->cacheMisses(), misses + 1);
+    QCOMPARE(authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None), Authority::Yes);
+    QCOMPARE(authority->cacheHits(), hits + 1);
+
+    // Different details are a different check
+    DetailsMap details;
+    details.insert("device", "/dev/null");
+    authority->checkAuthorizationSyncWithDetails("org.qt.policykit.examples.cry", process, Authority::None, details);
+    QCOMPARE(authority->cacheMisses(), misses + 2);
+
+    // Challenges are only cached when asked for
+    authority->checkAuthorizationSync("org.qt.policykit.examples.bleed", process, Authority::None);
+    authority->checkAuthorizationSync("org.qt.policykit.examples.bleed", process, Authority::None);
+    QCOMPARE(authority->cacheMisses(), misses + 4);
+
+    authority->clearCache();
+    authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None);
+    QCOMPARE(authority->cacheMisses(), misses + 5);
+    QCOMPARE(authority->cacheHits(), hits + 1);
+    QVERIFY(!authority->hasError());
+
+    authority->setCacheMode(Authority::CacheDisabled);
+}
+
+void TestAuth::test_Auth_checkAuthorizationResult()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    Authority::CheckResult result = authority->checkAuthorizationResultSync("org.qt.policykit.examples.cry", process, Authority::None);
+    QVERIFY(!result.isError());
+    QCOMPARE(result.result, Authority::Yes);
+
+    // Errors come with the result and leave the error state alone
+    result = authority->checkAuthorizationResultSync("org.qt.policykit.examples.cry", Subject(), Authority::None);
+    QVERIFY(result.isError());
+    QCOMPARE(result.error, Authority::E_WrongSubject);
+    QCOMPARE(result.result, Authority::Unknown);
+    QVERIFY(!authority->hasError());
+
+    QFuture<Authority::CheckResult> future = authority->checkAuthorizationResultAsync("org.qt.policykit.examples.kick", process, Authority::None);
+    wait();
+    QVERIFY(future.isFinished());
+    QVERIFY(!future.result().isError());
+    QCOMPARE(future.result().result, Authority::No);
+    QVERIFY(!authority->hasError());
+}
+
+void TestAuth::test_Auth_checkAuthorizationBatch()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    QList<Authority::CheckRequest> requests;
+    requests << Authority::CheckRequest("org.qt.policykit.examples.kick", process)
+             << Authority::CheckRequest("org.qt.policykit.examples.cry", process)
+             << Authority::CheckRequest("org.qt.policykit.examples.bleed", process);
+
+    QVector<Authority::CheckResult> results = authority->checkAuthorizationBatchSync(requests, Authority::None);
+    QCOMPARE(results.size(), 3);
+    QCOMPARE(results.at(0).result, Authority::No);
+    QCOMPARE(results.at(1).result, Authority::Yes);
+    QCOMPARE(results.at(2).result, Authority::Challenge);
+    QVERIFY(!authority->hasError());
+
+    QFuture<QVector<Authority::CheckResult> > future = authority->checkAuthorizationBatch(requests, Authority::None);
+    wait();
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result().size(), results.size());
+    for (int i = 0; i < results.size(); ++i) {
+        QCOMPARE(future.result().at(i).result, results.at(i).result);
+    }
+    QVERIFY(!authority->hasError());
+
+    // A failing check only affects its own result
+    requests << Authority::CheckRequest("org.qt.policykit.examples.cry", Subject());
+    results = authority->checkAuthorizationBatchSync(requests, Authority::None);
+    QCOMPARE(results.at(1).result, Authority::Yes);
+    QVERIFY(!results.at(1).isError());
+    QCOMPARE(results.at(3).result, Authority::Unknown);
+    QCOMPARE(results.at(3).error, Authority::E_WrongSubject);
+    QVERIFY(!authority->hasError());
+
+    // An empty batch finishes right away
+    QVERIFY(authority->checkAuthorizationBatchSync(QList<Authority::CheckRequest>(), Authority::None).isEmpty());
+}
+
+void TestAuth::test_Auth_workerThread()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    authority->setWorkerThreadEnabled(true);
+    QVERIFY(authority->isWorkerThreadEnabled());
+
+    // Results still arrive in this thread, through the Qt event loop
+    QFuture<Authority::Result> cry = authority->checkAuthorizationAsync("org.qt.policykit.examples.cry", process, Authority::None);
+    QFuture<ActionDescription::List> actions = authority->enumerateActionsAsync();
+    wait();
+    QVERIFY(cry.isFinished() && actions.isFinished());
+    QCOMPARE(cry.result(), Authority::Yes);
+    QVERIFY(!actions.result().isEmpty());
+    QVERIFY(!authority->hasError());
+
+    authority->setWorkerThreadEnabled(false);
+}
+
+void TestAuth::test_Auth_threads()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    Authority *authority = Authority::instance();
+    QList<CheckThread *> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads << new CheckThread;
+        threads.last()->start();
+    }
+
+    Q_FOREACH (CheckThread *thread, threads) {
+        QVERIFY(thread->wait());
+        QVERIFY(thread->failed);
+        QCOMPARE(thread->result, Authority::Yes);
+        delete thread;
+    }
+    // None of the errors of the threads leaked into this one
+    QVERIFY(!authority->hasError());
+}
+
+void TestAuth::test_Auth_statistics()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+    authority->resetStatistics();
+
+    // Nothing is recorded until enabled
+    authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None);
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).calls, quint64(0));
+
+    authority->setStatisticsEnabled(true);
+    QVERIFY(authority->isStatisticsEnabled());
+    authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None);
+    QFuture<Authority::Result> future = authority->checkAuthorizationAsync("org.qt.policykit.examples.kick",
+                                                                          process, Authority::None);
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).inFlight, 1);
+    wait();
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result(), Authority::No);
+
+    Authority::OperationStatistics stats = authority->statistics(Authority::CheckAuthorizationOperation);
+    QCOMPARE(stats.calls, quint64(2));
+    QCOMPARE(stats.errors, quint64(0));
+    QCOMPARE(stats.inFlight, 0);
+    QVERIFY(stats.p50 <= stats.p99);
+    QVERIFY(stats.p99 <= stats.maxLatency);
+
+    authority->setStatisticsEnabled(false);
+    authority->resetStatistics();
+    QCOMPARE(authority->statistics(Authority::CheckAuthorizationOperation).calls, quint64(0));
+}
+
+void TestAuth::test_Auth_tracer()
+{
+    // This needs the file org.qt.policykit.examples.policy from examples to be installed
+    UnixProcessSubject process(QCoreApplication::applicationPid());
+    Authority *authority = Authority::instance();
+
+    Tracer::setEnabled(true);
+    QVERIFY(Tracer::isEnabled());
+    Tracer::beginEvent("test", "tracerSpan");
+    authority->checkAuthorizationSync("org.qt.policykit.examples.cry", process, Authority::None);
+    Tracer::endEvent("test", "tracerSpan");
+    Tracer::setEnabled(false);
+
+    const QByteArray json = Tracer::toJson();
+    QVERIFY(json.startsWith("{"));
+    QVERIFY(json.contains("\"name\":\"tracerSpan\",\"cat\":\"test\",\"ph\":\"B\""));
+    QVERIFY(json.contains("\"name\":\"CheckAuthorizationOperation\",\"cat\":\"authority\",\"ph\":\"b\""));
+    QVERIFY(json.contains("\"name\":\"CheckAuthorizationOperation\",\"cat\":\"authority\",\"ph\":\"e\""));
+
+    // Nothing is recorded while disabled
+    Tracer::instantEvent("test", "notRecorded");
+    QVERIFY(!Tracer::toJson().contains("notRecorded"));
+
+    // The oldest events make room for new ones beyond the limit
+    const int limit = Tracer::threadEventLimit();
+    Tracer::setThreadEventLimit(2048);
+    QCOMPARE(Tracer::threadEventLimit(), 2048);
+    Tracer::setEnabled(true);
+    Tracer::instantEvent("test", "dropped");
+    for (int i = 0; i < 4096; ++i) {
+        Tracer::instantEvent("test", "kept");
+    }
+    Tracer::setEnabled(false);
+    const QByteArray limited = Tracer::toJson();
+    QVERIFY(!limited.contains("dropped"));
+    QVERIFY(limited.count("\"kept\"") <= 2048);
+    Tracer::setThreadEventLimit(limit);
+}
+
 void TestAuth::test_Auth_enumerateActions()
 {
     // This needs the file org.qt.policykit.examples.policy from examples to be installed
@@ -175,6 +447,22 @@ void TestAuth::test_Authority()
     // so this is not covered by this test
 }
 
+void TestAuth::test_Authority_coalescing()
+{
+    Authority *authority = Authority::instance();
+    QCOMPARE(authority->changeCoalescingInterval(), 0);
+
+    authority->setChangeCoalescingInterval(250);
+    QCOMPARE(authority->changeCoalescingInterval(), 250);
+
+    // Nothing is pending, so disabling coalescing again must not notify anything
+    QSignalSpy spy(authority, SIGNAL(authorizationsChanged(quint64)));
+    const quint64 generation = authority->changeGeneration();
+    authority->setChangeCoalescingInterval(0);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(authority->changeGeneration(), generation);
+}
+
 void TestAuth::test_Subject()
 {
     // Get pid of this application
@@ -232,6 +520,94 @@ void TestAuth::test_Details()
     QVERIFY(list.contains("2"));
     QVERIFY(list.contains("3"));
     QVERIFY(list.contains("4"));
+    QCOMPARE(details.toMap().size(), 4);
+    QCOMPARE(details.toMap().value("2"), QString("bbb"));
+
+    DetailsMap map;
+    map.insert("device", "/dev/sda");
+    const Details fromMap(map);
+    QCOMPARE(fromMap.lookup("device"), QString("/dev/sda"));
+    QCOMPARE(fromMap.toMap(), map);
+    QCOMPARE(Details(fromMap.details()).toMap(), map);
+}
+
+static bool writePolicyFile(const QString &fileName, const QByteArray &actions)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<policyconfig>\n"
+               "  <vendor>Polkit-qt</vendor>\n"
+               "  <icon_name>system-run</icon_name>\n");
+    file.write(actions);
+    file.write("</policyconfig>\n");
+    return true;
+}
+
+void TestAuth::test_PolicyFileSource()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString first = dir.path() + QStringLiteral("/org.qt.policykit.first.policy");
+    QVERIFY(writePolicyFile(first,
+                            "  <action id=\"org.qt.policykit.first.b\">\n"
+                            "    <description>Second</description>\n"
+                            "    <description xml:lang=\"de\">Zweite</description>\n"
+                            "    <message>Authentication is required</message>\n"
+                            "    <message xml:lang=\"de_AT\">Authentifizierung ist erforderlich</message>\n"
+                            "    <defaults><allow_active>auth_admin_keep</allow_active></defaults>\n"
+                            "  </action>\n"
+                            "  <action id=\"org.qt.policykit.first.a\">\n"
+                            "    <description>First</description>\n"
+                            "    <icon_name>dialog-password</icon_name>\n"
+                            "    <defaults><allow_any>no</allow_any><allow_active>yes</allow_active></defaults>\n"
+                            "  </action>\n"));
+    QVERIFY(writePolicyFile(dir.path() + QStringLiteral("/broken.policy"), "  <action id=\"broken\">\n"));
+
+    PolicyFileSource source(dir.path());
+    source.setLocale(QLocale(QStringLiteral("de_DE")));
+    QVERIFY(source.load());
+    ActionDescription::List actions = source.actions();
+    // Sorted by id, without the broken file
+    QCOMPARE(actions.size(), 2);
+    QCOMPARE(actions.at(0).actionId(), QStringLiteral("org.qt.policykit.first.a"));
+    QCOMPARE(actions.at(0).iconName(), QStringLiteral("dialog-password"));
+    QCOMPARE(actions.at(0).implicitAny(), ActionDescription::NotAuthorized);
+    QCOMPARE(actions.at(0).implicitActive(), ActionDescription::Authorized);
+    QCOMPARE(actions.at(1).description(), QStringLiteral("Zweite"));
+    // Translated to another country only
+    QCOMPARE(actions.at(1).message(), QStringLiteral("Authentication is required"));
+    QCOMPARE(actions.at(1).vendorName(), QStringLiteral("Polkit-qt"));
+    QCOMPARE(actions.at(1).iconName(), QStringLiteral("system-run"));
+    QCOMPARE(actions.at(1).implicitActive(), ActionDescription::AdministratorAuthenticationRequiredRetained);
+
+    // Nothing to parse again
+    QVERIFY(!source.load());
+
+    source.setWatching(true);
+    QSignalSpy spy(&source, SIGNAL(changed()));
+    QVERIFY(writePolicyFile(dir.path() + QStringLiteral("/org.qt.policykit.second.policy"),
+                            "  <action id=\"org.qt.policykit.second\">\n"
+                            "    <description>Added</description>\n"
+                            "  </action>\n"));
+    QVERIFY(spy.wait());
+    QCOMPARE(source.actions().size(), 3);
+
+    QVERIFY(QFile::remove(first));
+    QVERIFY(spy.wait());
+    QCOMPARE(source.actions().size(), 1);
+    QCOMPARE(source.actions().first().actionId(), QStringLiteral("org.qt.policykit.second"));
+
+    // A new locale drops the actions, also those of files removed meanwhile
+    source.setWatching(false);
+    QVERIFY(QFile::remove(dir.path() + QStringLiteral("/org.qt.policykit.second.policy")));
+    source.setLocale(QLocale(QStringLiteral("en_US")));
+    QVERIFY(source.actions().isEmpty());
+    QVERIFY(source.load());
+    QVERIFY(source.actions().isEmpty());
+    QVERIFY(!source.load());
 }
 
 QTEST_MAIN(TestAuth)
@@ -9,12 +9,23 @@ class TestAuth : public QObject
     Q_OBJECT
 private Q_SLOTS:
     void test_Auth_checkAuthorization();
+    void test_Auth_ready();
+    void test_Auth_checkAuthorizationAsync();
+    void test_Auth_cache();
+    void test_Auth_checkAuthorizationResult();
+    void test_Auth_checkAuthorizationBatch();
+    void test_Auth_workerThread();
+    void test_Auth_threads();
+    void test_Auth_statistics();
+    void test_Auth_tracer();
     void test_Auth_enumerateActions();
     void test_Identity();
     void test_Authority();
+    void test_Authority_coalescing();
     void test_Subject();
     void test_Session();
     void test_Details();
+    void test_PolicyFileSource();
 };
 
 #endif // TEST_H